@@ -0,0 +1,61 @@
+#ifndef ACCOUNT_INDEX_H
+#define ACCOUNT_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "BankAccount.h"
+
+// One page of accounts whose key starts with a prefix
+struct PrefixMatches {
+    size_t total;                  // Matches across all pages
+    std::vector<size_t> accounts;  // Positions in the accounts vector for this page
+};
+
+// Sorted-prefix index over account codes and owner names (ASCII letters
+// compared case-insensitively). A lookup costs two binary searches plus the
+// size of the requested page, however large the book is.
+class AccountIndex {
+private:
+    struct Entry {
+        std::string key;           // Case-folded code or owner name
+        size_t account;            // Position in the accounts vector
+    };
+
+    std::vector<Entry> byCode;
+    std::vector<Entry> byOwner;
+
+    static std::string fold(const char* text);
+    static bool entryLess(const Entry& a, const Entry& b);
+    static void insert(std::vector<Entry>& entries, const char* text, size_t account);
+    typedef std::vector<Entry>::const_iterator EntryIterator;
+    static void range(const std::vector<Entry>& entries, const std::string& folded,
+                      EntryIterator& first, EntryIterator& last);
+    static PrefixMatches find(const std::vector<Entry>& entries, const std::string& prefix,
+                              size_t offset, size_t limit);
+
+public:
+    void rebuild(const std::vector<BankAccount>& accounts);
+
+    // Registers an account appended at `position`
+    void add(const BankAccount& account, size_t position);
+
+    size_t size() const;
+
+    // Heap bytes held by both sorted entry arrays and their keys
+    size_t memoryUsage() const;
+
+    PrefixMatches findByCode(const std::string& prefix, size_t offset, size_t limit) const;
+    PrefixMatches findByOwner(const std::string& prefix, size_t offset, size_t limit) const;
+
+    // Code matches followed by owner matches. An account matching both is
+    // listed once, among the code matches; telling them apart costs a pass
+    // over the owner matches when the prefix matches codes as well.
+    PrefixMatches findByCodeOrOwner(const std::vector<BankAccount>& accounts, const std::string& prefix,
+                                    size_t offset, size_t limit) const;
+
+    // Exact code lookup; returns false when no account has the code
+    bool findCode(const std::string& code, size_t& position) const;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef ACCOUNT_STORAGE_H
+#define ACCOUNT_STORAGE_H
+
+#include <string>
+#include <vector>
+#include "BankAccount.h"
+#include "Checksum.h"
+
+// Writes the account count followed by every account, then the CRC32C trailer.
+// Throws std::runtime_error when the file cannot be written.
+void saveAccountsFile(const std::string& filename, const std::vector<BankAccount>& accounts);
+
+// Parses the file and verifies its checksums in the same pass; the accounts
+// are only replaced once both succeed. Returns false when the file does not
+// exist; throws std::runtime_error when it is corrupted or malformed.
+// `report` receives the verification result if given.
+bool loadAccountsFile(const std::string& filename, std::vector<BankAccount>& accounts,
+                      ChecksumReport* report = nullptr);
+
+// Parser behind loadAccountsFile: reads the file in large blocks, parses numbers
+// without locales and builds each account in place. Throws on malformed input.
+void parseAccountsFile(const std::string& filename, std::vector<BankAccount>& accounts);
+
+#endif
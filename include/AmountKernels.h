@@ -0,0 +1,43 @@
+#ifndef AMOUNT_KERNELS_H
+#define AMOUNT_KERNELS_H
+
+#include <string>
+#include <cstddef>
+
+// Bulk kernels over contiguous amount arrays. The widest instruction set the
+// CPU supports (AVX-512, AVX2 or SSE2) is picked once at startup; other
+// platforms use the scalar versions.
+//
+// Sums use several independent accumulators, so they may differ from a
+// left-to-right scalar sum in the last bits. They are meant for book-wide
+// aggregates only; per-account totals are kept by BankAccount in append
+// order. Every other kernel gives exactly the scalar result.
+
+double sumAmounts(const double* values, size_t count);
+
+// Number of values >= threshold
+size_t countAtLeast(const double* values, size_t count, double threshold);
+
+// Number of positions where a[i] == b[i]
+size_t countEqual(const double* a, const double* b, size_t count);
+
+// out[i] = a[i] - b[i]
+void subtractAmounts(const double* a, const double* b, double* out, size_t count);
+
+// Most bins histogramAmounts accepts
+const size_t MAX_HISTOGRAM_BINS = 1000;
+
+// Adds each value to one of `binCount` bins of `width` starting at `lower`.
+// Values below the first bin land in it, values past the last bin in the last one.
+// Throws std::invalid_argument when binCount exceeds MAX_HISTOGRAM_BINS.
+void histogramAmounts(const double* values, size_t count, double lower, double width,
+                      size_t binCount, size_t* bins);
+
+// Name of the implementation in use ("avx512", "avx2", "sse2" or "scalar")
+const char* amountKernelsImplementation();
+
+// Runs every implementation this CPU supports against the scalar one.
+// Returns false and describes the first disagreement in `failure`.
+bool verifyAmountKernels(std::string& failure);
+
+#endif
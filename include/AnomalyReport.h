@@ -0,0 +1,28 @@
+#ifndef ANOMALY_REPORT_H
+#define ANOMALY_REPORT_H
+
+#include <vector>
+#include <iostream>
+#include <cstddef>
+#include "SnapshotRegistry.h"
+
+struct Anomaly {
+    size_t account;          // Position in the snapshot
+    bool deposit;            // False when the withdrawal series is unusual
+    double last;             // The unusual amount
+    double earlierMean;      // Mean and deviation of the amounts before it
+    double earlierStddev;
+    double deviation;        // |last - earlierMean| / earlierStddev (may be infinite)
+};
+
+// Accounts whose latest deposit or latest withdrawal lies more than
+// `threshold` standard deviations from the amounts before it. Reads only the
+// statistics kept with each account, never the transaction arrays. Sorted
+// by deviation, largest first.
+std::vector<Anomaly> findAnomalies(const BookSnapshot& book, double threshold);
+
+// Table of the first `limit` anomalies with each account's large-transaction count
+void printAnomalies(const BookSnapshot& book, const std::vector<Anomaly>& anomalies,
+                    size_t limit, std::ostream& out);
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <cstring>
+#include <cstddef>
+#include "TransactionStats.h"
 
 class BankAccount {
 private:
@@ -14,11 +16,20 @@ private:
     int withdrawnCount;      // Number of withdrawn amounts
     int depositedCapacity;   // Capacity of deposited array
     int withdrawnCapacity;   // Capacity of withdrawn array
+    double depositedTotal;   // Running sums in append order, so totals match a
+    double withdrawnTotal;   // left-to-right loop on every CPU
+    TransactionStats depositStats;    // Maintained on every append
+    TransactionStats withdrawalStats;
+    int recentTransactions;  // Appends since the account was loaded or last compacted
+    bool compactedSinceLoad; // Lets compaction tell an idle account from a freshly loaded one
+    bool unsavedChanges;     // Created or changed since it was loaded or last saved to a shard
 
     void validateUniqueCode(const char* code) const;
     void validateOwnerName(const char* name) const;
     void resizeDepositedArray();
     void resizeWithdrawnArray();
+    
+    explicit BankAccount(std::nullptr_t); // Empty shell for fromLoadedState to fill in
 
 public:
     BankAccount();
@@ -27,31 +38,64 @@ public:
     
     BankAccount(const BankAccount& other);
     
+    // Leaves `other` without transactions and with an empty code and owner name
+    BankAccount(BankAccount&& other) noexcept;
+    
     ~BankAccount();
 
     const char* getUniqueCode() const;
     const char* getOwnerName() const;
     int getDepositedCount() const;
     int getWithdrawnCount() const;
+    double getDepositedAmount(int index) const;
+    double getWithdrawnAmount(int index) const;
     double getTotalDeposited() const;
     double getTotalWithdrawn() const;
     double getBalance() const; // Difference between deposited and withdrawn
+    const TransactionStats& getDepositStats() const;
+    const TransactionStats& getWithdrawalStats() const;
+    int getDepositedCapacity() const;
+    int getWithdrawnCapacity() const;
+    int getRecentTransactions() const;
+    bool isDormant() const;  // No appends over a whole period between two compactions
+    bool hasUnsavedChanges() const;
 
     void setUniqueCode(const char* code);
     void setOwnerName(const char* name);
+    void setUnsavedChanges(bool unsaved); // Set by sharded storage once the owning shard is saved
     
     void addDeposit(double amount);
     void addWithdrawal(double amount);
+    void reserveTransactions(int extraDeposits, int extraWithdrawals); // Pre-grow arrays so appends cannot throw
+    
+    // Trims both arrays to fit when the account is dormant and leaves other
+    // accounts their headroom; then restarts the recent-transaction count.
+    // Returns true when the account was dormant.
+    bool compact();
     
     bool hasEqualDepositsAndWithdrawals() const; // Check if totals are equal
 
     BankAccount& operator=(const BankAccount& other);
+    BankAccount& operator=(BankAccount&& other) noexcept;
     
     friend std::ostream& operator<<(std::ostream& os, const BankAccount& account);
     friend std::istream& operator>>(std::istream& is, BankAccount& account);
     
     void saveToFile(std::ostream& os) const;
     void loadFromFile(std::istream& is);
+    
+    // Array size a loader should allocate for `count` amounts: an eighth more,
+    // so the first appends after a load do not copy the history
+    static int loadedCapacity(int count);
+    
+    // Takes ownership of new[]-allocated buffers produced by a parser (no validation, no copies);
+    // each must hold loadedCapacity(count) amounts. Statistics read from the file are used when
+    // their counts match; otherwise they are recomputed.
+    static BankAccount fromLoadedState(char* code, char* name,
+                                       double* deposits, int depositCount,
+                                       double* withdrawals, int withdrawalCount,
+                                       const TransactionStats* savedDepositStats = nullptr,
+                                       const TransactionStats* savedWithdrawalStats = nullptr);
 };
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef BATCH_MODE_H
+#define BATCH_MODE_H
+
+#include <iostream>
+#include <vector>
+#include "BankAccount.h"
+#include "TransferEngine.h"
+#include "SnapshotRegistry.h"
+#include "AccountIndex.h"
+
+// Everything a batch script may operate on
+struct BatchContext {
+    std::vector<BankAccount>& accounts;
+    TransferEngine& transfers;
+    SnapshotRegistry& snapshots;
+    AccountIndex& index;
+};
+
+// Executes commands from a script, one per line. Returns the number of failed commands.
+//
+//   transfer <from-code> <to-code> <amount>   queue a transfer in the pending batch
+//   commit                                    apply the pending batch atomically
+//   abort                                     discard the pending batch
+//   balance <code>                            print the balance of an account
+//   report                                    print totals per account from the current snapshot
+//   find-code <prefix> [limit]                list accounts whose code starts with the prefix
+//   find-owner <prefix>                       list accounts whose owner name starts with the
+//                                             prefix (rest of the line, spaces included)
+//   book-stats [bins]                         book totals and a histogram of balances
+//                                             (1 to 1000 bins, default 10)
+//   count-above <amount>                      number of accounts with balance >= amount
+//   verify-kernels                            check the vector kernels against the scalar ones
+//   export accounts|transactions <file>       write the book as CSV or JSON Lines (by extension)
+//   export-dat <dat> accounts|transactions <file>
+//                                             convert a data file without loading it
+//   import accounts|transactions <file>       add accounts or apply transactions from CSV/JSONL;
+//                                             any rejected row counts as a failure
+//   ingest <feed>                             apply a transactions feed through the pipelined
+//                                             ingester; any rejected row counts as a failure
+//   anomalies [sigmas] [limit]                accounts whose latest deposit or withdrawal lies more
+//                                             than sigmas (default 3) std devs from earlier ones
+//   account-stats <code>                      maintained deposit and withdrawal statistics
+//   memory                                    bytes used by accounts, arrays, index and snapshot
+//   compact                                   trim array slack of accounts idle since the
+//                                             previous compact
+//   save-shards <count>                       save as <count> shard files (0 = single file);
+//                                             later saves keep the layout
+//
+// Blank lines and lines starting with '#' are ignored.
+int runBatchMode(std::istream& in, std::ostream& out, BatchContext& context);
+
+#endif
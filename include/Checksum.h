@@ -0,0 +1,110 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU has it
+// and a table-driven implementation otherwise. Pass the previous result as
+// `crc` to continue a checksum over several pieces.
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+// Name of the implementation picked at runtime ("sse4.2" or "portable")
+const char* crc32cImplementation();
+
+// Payload is checksummed in blocks of this size; the trailer lists every
+// block's CRC and a file CRC computed over the block CRCs.
+const size_t CHECKSUM_BLOCK_SIZE = 1 << 20;
+
+// Output buffer that checksums everything written through it and appends
+// the checksum trailer when finish() is called:
+//
+//   #CRC32C-BLOCKS <block size> <block count>
+//   <block crc, 8 hex digits>            (one line per block)
+//   #CRC32C <payload length> <file crc>
+//
+// Readers that stop after the last account never see the trailer.
+class ChecksumStreamBuf : public std::streambuf {
+private:
+    std::streambuf* target;
+    std::vector<char> buffer;
+    std::vector<uint32_t> blockCrcs;
+    unsigned long long payloadLength;
+    bool finished;
+
+    bool writeBlock();
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+public:
+    explicit ChecksumStreamBuf(std::streambuf* target);
+
+    ChecksumStreamBuf(const ChecksumStreamBuf&) = delete;
+    ChecksumStreamBuf& operator=(const ChecksumStreamBuf&) = delete;
+
+    // Writes the last partial block and the trailer; returns false on I/O failure
+    bool finish();
+};
+
+struct ChecksumReport {
+    bool hasChecksums;              // False for files written before checksums existed
+    bool valid;                     // True when every block and the file CRC match
+    unsigned long long payloadLength;
+    size_t blockCount;
+    size_t badBlocks;
+    size_t firstBadBlock;
+    std::string error;              // Reason when the trailer itself is unusable
+
+    ChecksumReport();
+};
+
+// Expected checksums read from a file's trailer
+struct ChecksumTrailer {
+    unsigned long long payloadLength;
+    size_t blockSize;
+    std::vector<uint32_t> blockCrcs;
+};
+
+// Reads only the trailer at the end of a file of `fileSize` bytes and leaves
+// the stream position undefined. Returns false when there is no usable
+// trailer: with report.error set if it is damaged, and with
+// report.hasChecksums unset if the last lines carry no footer at all.
+bool readChecksumTrailer(std::istream& file, unsigned long long fileSize,
+                         ChecksumTrailer& trailer, ChecksumReport& report);
+
+// Checks the payload blocks against a trailer as the bytes stream past, in
+// pieces of any size, so a reader can verify a file while parsing it
+class BlockVerifier {
+private:
+    ChecksumTrailer trailer;
+    unsigned long long seen;         // Payload bytes checked so far
+    size_t block;                    // Block being checked
+    size_t blockFill;
+    uint32_t crc;
+    size_t badBlocks;
+    size_t firstBadBlock;
+
+public:
+    explicit BlockVerifier(const ChecksumTrailer& trailer);
+
+    // Bytes past the end of the payload are ignored
+    void update(const char* data, size_t length);
+
+    unsigned long long remaining() const;  // Payload bytes not seen yet
+
+    // Fills in the block results; blocks not seen in full count as bad
+    void finish(ChecksumReport& report) const;
+};
+
+// Checks the trailer and every block of a data file without parsing accounts.
+// A file with trailer lines but no valid footer is reported as damaged, never
+// as a file without checksums.
+ChecksumReport verifyChecksums(const std::string& filename);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef DAT_READER_H
+#define DAT_READER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "TransactionStats.h"
+#include "Checksum.h"
+
+// Locale-independent number parsing over [begin, end). Both return false
+// unless the whole range is a valid number. Amounts are correctly rounded,
+// so they match what `istream >> double` produces for the same text.
+bool parseAmount(const char* begin, const char* end, double& value);
+bool parseInteger(const char* begin, const char* end, long long& value);
+
+// Writes the shortest of %.15g / %.17g that parseAmount reads back as exactly
+// `value` and returns its length. `text` must have room for 32 characters.
+size_t formatAmount(double value, char* text);
+
+// Reads a text file in large blocks and hands out one line at a time
+// without copying. Every field of the .dat format sits on its own line.
+class DatReader {
+private:
+    std::ifstream file;
+    std::vector<char> buffer;
+    size_t position;                 // Next unread byte in buffer
+    size_t filled;                   // Bytes of buffer holding file data
+    unsigned long long consumed;     // File offset of buffer[0]
+    unsigned long long fileSize;
+    unsigned long long lineNumber;
+    bool verifying;
+    std::unique_ptr<BlockVerifier> verifier; // Set when the file has a usable trailer
+    ChecksumReport verification;
+
+    bool refill();
+    [[noreturn]] void fail(const char* what) const;
+
+public:
+    explicit DatReader(const std::string& filename, size_t blockSize = 1 << 20);
+
+    DatReader(const DatReader&) = delete;
+    DatReader& operator=(const DatReader&) = delete;
+
+    bool isOpen() const;
+
+    // Checks the CRC32C trailer against the blocks as they are read, so a
+    // file is verified in the same pass that parses it. Reads only the
+    // trailer now; call before the first line.
+    void beginVerification();
+
+    // Reads any payload the parser left and returns the result. Without a
+    // trailer, anything but whitespace after the last record is reported as
+    // a damaged trailer rather than accepted as a file without checksums.
+    ChecksumReport finishVerification();
+
+    // Next line without its terminator; the text stays valid until the next call
+    bool nextLine(const char*& text, size_t& length);
+
+    // Typed .dat fields; these throw std::runtime_error naming the line on bad input
+    void nextCode(const char*& text, size_t& length);       // First token of the line
+    void nextOwnerName(const char*& text, size_t& length);  // Whole line, spaces included
+    unsigned long long nextAccountCount();
+    int nextTransactionCount();
+    double nextAmount();
+
+    // Consumes the optional "@stats" line that follows an account. Returns false,
+    // consuming nothing, when the next line is something else; a malformed
+    // stats line is consumed and also yields false.
+    bool nextStats(TransactionStats& deposits, TransactionStats& withdrawals);
+
+    unsigned long long bytesRead() const;
+    unsigned long long bytesRemaining() const;
+};
+
+#endif
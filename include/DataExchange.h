@@ -0,0 +1,69 @@
+#ifndef DATA_EXCHANGE_H
+#define DATA_EXCHANGE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "BankAccount.h"
+#include "AccountIndex.h"
+
+// Interchange formats, picked from the file extension (.csv, .jsonl/.ndjson)
+enum class ExchangeFormat { Csv, JsonLines };
+
+// What one row/line describes:
+//   Accounts      CSV:   code,owner,deposits,withdrawals,total_deposited,total_withdrawn,balance
+//                 JSONL: {"code":..,"owner":..,"deposits":[..],"withdrawals":[..]}
+//   Transactions  CSV:   code,type,amount            (type is "deposit" or "withdrawal")
+//                 JSONL: {"code":..,"type":..,"amount":..}
+// Account CSV rows carry totals only; the other three forms are lossless.
+enum class ExchangeRecords { Accounts, Transactions };
+
+struct ImportResult {
+    size_t imported;
+    size_t rejected;
+    std::vector<std::string> errors;   // First few rejections with their line numbers
+
+    ImportResult();
+};
+
+struct TransactionRow {
+    std::string code;
+    bool deposit;                      // False for a withdrawal
+    double amount;
+};
+
+// Parses transaction rows of one format; keep one per thread
+class TransactionRowParser {
+private:
+    ExchangeFormat format;
+    std::vector<std::string> fields;   // Reused between CSV rows
+
+public:
+    explicit TransactionRowParser(ExchangeFormat format);
+
+    // Returns false for blank lines and the CSV header; throws
+    // std::invalid_argument when the row is malformed
+    bool parse(const char* text, size_t length, bool firstLine, TransactionRow& row);
+};
+
+ExchangeFormat exchangeFormatFor(const std::string& filename);
+ExchangeRecords exchangeRecordsFor(const std::string& kind);   // "accounts" or "transactions"
+
+// Streams every account to `filename` through a large output buffer
+void exportAccounts(const std::vector<BankAccount>& accounts, const std::string& filename,
+                    ExchangeRecords records);
+
+// Converts a .dat file straight to `filename` without building BankAccount
+// objects; memory use does not depend on the size of the book. Throws
+// std::runtime_error, before creating `filename`, when the checksums do not match.
+void exportDataFile(const std::string& dataFile, const std::string& filename,
+                    ExchangeRecords records);
+
+// Appends accounts or applies transactions read from `filename` one line at a
+// time. Bad rows are counted and skipped; accounts whose code already exists
+// are rejected. Added accounts are appended and the index is rebuilt once
+// at the end, so a bulk import costs O(N log N) rather than a sorted insert per row.
+ImportResult importRecords(const std::string& filename, ExchangeRecords records,
+                           std::vector<BankAccount>& accounts, AccountIndex& index);
+
+#endif
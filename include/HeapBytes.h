@@ -0,0 +1,20 @@
+#ifndef HEAP_BYTES_H
+#define HEAP_BYTES_H
+
+#include <string>
+#include <functional>
+#include <cstddef>
+
+// Heap bytes owned by a string; 0 when it fits inside the string object.
+// std::less gives a total order even for pointers into unrelated objects.
+inline size_t heapBytes(const std::string& text) {
+    const std::less<const char*> before;
+    const char* data = text.data();
+    const char* object = reinterpret_cast<const char*>(&text);
+    if (!before(data, object) && before(data, object + sizeof(text))) {
+        return 0; // Short string stored in place
+    }
+    return text.capacity() + 1;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include "AccountIndex.h"
+#include "TransferEngine.h"
+
+// Applies a feed of deposits and withdrawals (the transactions CSV or JSON
+// Lines format of DataExchange.h) to existing accounts. Four threads work on
+// it at once:
+//
+//   reader -> parser -> validator -> applier
+//
+// Each stage hands chunks of lines to the next through a bounded lock-free
+// queue, so a slow stage holds back the ones before it and memory stays
+// bounded. The applier posts each chunk through TransferEngine::applyPostings,
+// grouped per account, and writes rejected rows to "<feed>.rejected" as
+// "<line>\t<reason>\t<row>".
+
+struct StageStats {
+    std::string name;
+    unsigned long long items;        // Bytes for the reader, rows for the other stages
+    double busySeconds;              // Time spent working, not waiting on a queue
+};
+
+struct QueueStats {
+    std::string name;
+    size_t capacity;                 // In chunks
+    size_t highWater;                // Most chunks ever waiting in the queue
+    size_t fullWaits;                // Times the producer found it full (back-pressure)
+};
+
+struct IngestReport {
+    unsigned long long bytes;
+    unsigned long long rows;         // Rows seen, without blank lines and the CSV header
+    unsigned long long applied;
+    unsigned long long rejected;
+    double seconds;
+    std::string rejectedFile;        // Empty when no row was rejected
+    std::vector<std::string> errors; // First few rejections with their line numbers
+    std::string error;               // Set when ingestion stopped early (I/O failure, including
+                                     // the rejected-rows file)
+    std::vector<StageStats> stages;
+    std::vector<QueueStats> queues;
+
+    IngestReport();
+};
+
+// Runs the whole feed through the pipeline into the engine's accounts, which
+// must not be resized meanwhile. Throws std::runtime_error when the feed
+// cannot be opened. An exception escaping any stage (e.g. std::bad_alloc)
+// stops the others and is rethrown here once every stage thread has ended;
+// chunks applied before it stay applied.
+IngestReport ingestTransactions(const std::string& feed, const AccountIndex& index,
+                                TransferEngine& transfers);
+
+// Totals, throughput per stage and queue high-water marks
+void printIngestReport(const IngestReport& report, std::ostream& out);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstddef>
+#include "BankAccount.h"
+#include "AccountIndex.h"
+#include "SnapshotRegistry.h"
+
+// Bytes requested from the allocator by each part of the book. The
+// allocator's own per-block overhead is not included.
+struct MemoryReport {
+    size_t accounts;
+    size_t activeAccounts;   // Accounts with transactions since loading or the last compaction
+    size_t objectBytes;      // BankAccount objects, including spare capacity of the vector
+    size_t codeBytes;
+    size_t nameBytes;
+    size_t depositBytes;     // Stored amounts
+    size_t withdrawalBytes;
+    size_t depositSlack;     // Allocated but unused array space
+    size_t withdrawalSlack;
+    size_t dormantSlack;     // Part of the slack held by dormant accounts (BankAccount::isDormant)
+    size_t indexBytes;
+    size_t snapshotBytes;    // Current snapshot version
+
+    MemoryReport();
+
+    size_t accountBytes() const; // Everything owned by the accounts vector
+    size_t total() const;
+};
+
+struct CompactionResult {
+    size_t dormant;          // Accounts trimmed to fit
+    size_t active;           // Accounts left with their growth headroom
+    size_t bytesBefore;      // MemoryReport::accountBytes() before and after
+    size_t bytesAfter;
+};
+
+MemoryReport measureMemory(const std::vector<BankAccount>& accounts, const AccountIndex& index,
+                           const BookSnapshot& snapshot);
+
+// Table of bytes per part with its share of the total
+void printMemoryReport(const MemoryReport& report, std::ostream& out);
+
+// Trims the arrays of accounts that had no appends since the previous
+// compaction to fit, and releases spare capacity of the accounts vector.
+// Other accounts, including ones loaded since then, keep their headroom so
+// their next appends do not copy the whole history. Positions do not change,
+// so the index and snapshots stay valid; must not run while transfers or an
+// ingest are in progress.
+CompactionResult compactAccounts(std::vector<BankAccount>& accounts);
+
+void printCompactionResult(const CompactionResult& result, std::ostream& out);
+
+#endif
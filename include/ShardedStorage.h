@@ -0,0 +1,79 @@
+#ifndef SHARDED_STORAGE_H
+#define SHARDED_STORAGE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "BankAccount.h"
+
+// Sharded layout: accounts are spread over N data files by a hash of their
+// unique code, e.g. bank_accounts.shard-03-of-08.dat, and a manifest
+// (bank_accounts.manifest) lists every shard with its account count, size
+// and CRC32C. Shards are ordinary checksummed .dat files and are loaded and
+// saved in parallel, one thread per shard.
+
+const size_t MAX_SHARDS = 64;
+
+struct ShardStatus {
+    std::string filename;
+    size_t accounts;
+    unsigned long long bytes;
+    uint32_t crc;                   // CRC32C of the whole shard file
+    bool written;                   // Save only: false when the shard was unchanged
+    std::string error;              // Empty when the shard loaded or saved fine
+    std::string warning;            // Load only: shard is valid but differs from the manifest
+
+    ShardStatus();
+};
+
+struct ShardReport {
+    std::vector<ShardStatus> shards;
+
+    size_t failedCount() const;
+    size_t writtenCount() const;
+};
+
+// Shard an account belongs to (FNV-1a of the code, modulo the shard count)
+size_t shardOf(const char* uniqueCode, size_t shardCount);
+
+// "dir/bank_accounts.manifest" -> "dir/bank_accounts.shard-03-of-08.dat"
+std::string shardFileName(const std::string& manifest, size_t shard, size_t shardCount);
+
+// Number of shards in the manifest, or 0 when there is no manifest.
+// Throws std::runtime_error when the manifest is corrupted.
+size_t readShardCount(const std::string& manifest);
+
+// Streams each shard holding new or changed accounts (see
+// BankAccount::hasUnsavedChanges) to a temporary file that replaces the old
+// one, then writes the manifest; other shards are not touched. Changing the
+// layout rewrites every shard. A shard that fails to save keeps its old file
+// and manifest entry; check failedCount(). If a layout change fails, the new
+// shard files are removed and the old layout stays. Once every shard is
+// saved, shard files of a previous layout and the single-file layout of the
+// same book (bank_accounts.dat next to bank_accounts.manifest) are removed.
+ShardReport saveShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                       size_t shardCount);
+
+// Loads every shard listed in the manifest. A shard that is missing or
+// corrupted, or holds accounts of another shard, is reported in its status and
+// left out; the other shards still load. Returns false when there is no
+// manifest; throws std::runtime_error when the manifest itself is corrupted.
+bool loadShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                ShardReport& report);
+
+// Rebuilds a damaged manifest from the shard files on disk. Succeeds only when
+// exactly one shard layout is present, complete, and every shard loads; the
+// damaged manifest is kept as <manifest>.corrupt. Returns false otherwise,
+// leaving `accounts` untouched and the manifest in place.
+bool recoverShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                   ShardReport& report);
+
+// Shard files listed in the manifest that do not exist, e.g. because they were
+// set aside as corrupted. Saving over them would drop their accounts.
+std::vector<std::string> missingShards(const std::string& manifest);
+
+// Removes the manifest and the shard files it lists
+void removeShards(const std::string& manifest);
+
+#endif
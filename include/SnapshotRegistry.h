@@ -0,0 +1,85 @@
+#ifndef SNAPSHOT_REGISTRY_H
+#define SNAPSHOT_REGISTRY_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include "BankAccount.h"
+
+// Read-only summary of one account as of a published version
+struct AccountSnapshot {
+    // Shared between versions until the account's code or name changes,
+    // so copying an entry never copies the strings
+    std::shared_ptr<const std::string> uniqueCode;
+    std::shared_ptr<const std::string> ownerName;
+    int depositedCount;
+    int withdrawnCount;
+    double totalDeposited;
+    double totalWithdrawn;
+    TransactionStats depositStats;
+    TransactionStats withdrawalStats;
+
+    const std::string& getUniqueCode() const { return *uniqueCode; }
+    const std::string& getOwnerName() const { return *ownerName; }
+    double getBalance() const { return totalDeposited - totalWithdrawn; }
+};
+
+// Immutable view of the whole book. Accounts are stored in fixed-size chunks
+// shared between versions, so a new version only copies the chunks it changes.
+class BookSnapshot {
+private:
+    friend class SnapshotRegistry;
+
+    static const size_t CHUNK_SIZE = 256;
+
+    std::vector<std::shared_ptr<const std::vector<AccountSnapshot>>> chunks;
+    size_t accountCount;
+    unsigned long long version;
+
+public:
+    BookSnapshot();
+
+    size_t size() const;
+    bool empty() const;
+    unsigned long long getVersion() const;
+    const AccountSnapshot& operator[](size_t index) const;
+
+    // Copies the per-account totals into contiguous arrays for the bulk kernels
+    void collectTotals(std::vector<double>& deposited, std::vector<double>& withdrawn) const;
+
+    // Heap bytes of this version, counting chunks shared with other versions too
+    size_t memoryUsage() const;
+};
+
+// Publishes versioned snapshots of the account book. Readers take a reference
+// to the current version and never block writers; a version (and every chunk
+// only it uses) is freed as soon as its last reader lets go, so retained
+// memory is bounded by the chunks replaced since the oldest live reader.
+class SnapshotRegistry {
+private:
+    std::shared_ptr<const BookSnapshot> current;
+    std::mutex writerMutex;
+
+    // Refreshes `entry` from the account, reusing its strings when they still match
+    static void summarize(const BankAccount& account, AccountSnapshot& entry);
+
+public:
+    SnapshotRegistry();
+
+    SnapshotRegistry(const SnapshotRegistry&) = delete;
+    SnapshotRegistry& operator=(const SnapshotRegistry&) = delete;
+
+    // Current version; hold on to it for as long as a consistent view is needed
+    std::shared_ptr<const BookSnapshot> acquire() const;
+
+    // Rebuilds every chunk (after loading or removing accounts)
+    void publishAll(const std::vector<BankAccount>& accounts);
+
+    // Refreshes the listed accounts plus any appended since the last version.
+    // The caller must keep the listed accounts from changing during the call.
+    void publish(const std::vector<BankAccount>& accounts, const std::vector<size_t>& changed);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <cstddef>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. A full queue makes push() wait, which is what slows a
+// fast stage down to the pace of the stage after it. Waiting spins briefly,
+// then sleeps on a condition variable so an idle stage does not hold a core.
+template <typename T>
+class SpscQueue {
+private:
+    static const int SPIN_LIMIT = 64;       // Yields before a waiting side goes to sleep
+
+    std::vector<T> slots;
+    size_t mask;
+
+    // Each index is written by one side only; kept on separate cache lines
+    alignas(64) std::atomic<size_t> head;   // Next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> tail;   // Next slot to push (producer)
+
+    // Producer-side statistics, read once both threads are done
+    alignas(64) size_t highWater;
+    size_t fullWaits;
+
+    // Only touched once a side has to sleep
+    alignas(64) std::atomic<int> sleepers;
+    std::atomic<bool> closedFlag;
+    std::mutex sleepMutex;
+    std::condition_variable changed;
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    // Called after every head or tail update; the fence pairs with the one in
+    // waitUntil so either the sleeper sees the update or we see the sleeper
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            changed.notify_all();
+        }
+    }
+
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+            if (ready() || closed()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        changed.wait(lock, [this, &ready] { return ready() || closed(); });
+        sleepers.fetch_sub(1);
+    }
+
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots(roundUp(capacity)), mask(slots.size() - 1), head(0), tail(0),
+          highWater(0), fullWaits(0), sleepers(0), closedFlag(false) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T& value) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        const size_t depth = position - head.load(std::memory_order_acquire);
+        if (depth == slots.size()) {
+            return false;
+        }
+        slots[position & mask] = std::move(value);
+        tail.store(position + 1, std::memory_order_release);
+        if (depth + 1 > highWater) {
+            highWater = depth + 1;
+        }
+        wake();
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    // Returns false, dropping the value, once the queue is closed
+    bool push(T value) {
+        if (closed()) {
+            return false;
+        }
+        if (tryPush(value)) {
+            return true;
+        }
+        ++fullWaits;
+        while (!closed()) {
+            if (tryPush(value)) {
+                return true;
+            }
+            waitUntil([this] {
+                return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) <
+                       slots.size();
+            });
+        }
+        return false;
+    }
+
+    // Returns T() once the queue is closed, even if values are left in it
+    T pop() {
+        T value;
+        while (!closed()) {
+            if (tryPop(value)) {
+                return value;
+            }
+            waitUntil([this] {
+                return head.load(std::memory_order_relaxed) != tail.load(std::memory_order_acquire);
+            });
+        }
+        return T();
+    }
+
+    // Abandons the queue: wakes both sides and makes every later push and pop fail
+    void close() {
+        closedFlag.store(true);
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        changed.notify_all();
+    }
+
+    bool closed() const { return closedFlag.load(); }
+
+    size_t capacity() const { return slots.size(); }
+    size_t highWaterMark() const { return highWater; }
+    size_t fullWaitCount() const { return fullWaits; }  // Pushes that found the queue full
+};
+
+template <typename T>
+const int SpscQueue<T>::SPIN_LIMIT;
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef TRANSACTION_STATS_H
+#define TRANSACTION_STATS_H
+
+#include <iostream>
+#include <cstddef>
+
+// Amounts at or above this count as large transactions
+const double LARGE_TRANSACTION_AMOUNT = 10000.0;
+
+// Running statistics over one series of amounts, updated in O(1) per
+// amount with Welford's algorithm so the variance stays accurate for
+// long series of similar values.
+struct TransactionStats {
+    int count;
+    double mean;
+    double m2;               // Sum of squared differences from the mean
+    double min;
+    double max;
+    double last;             // Most recent amount
+    int largeCount;          // Amounts >= LARGE_TRANSACTION_AMOUNT
+    double earlierMean;      // mean and m2 before the last amount was added; undoing
+    double earlierM2;        // the update instead would cancel badly for outliers
+
+    TransactionStats();
+
+    void add(double amount);
+
+    double variance() const; // Population variance; 0 for fewer than two amounts
+    double stddev() const;
+
+    // Mean and standard deviation of every amount except the last one.
+    // Returns false when there are fewer than MIN_ANOMALY_HISTORY of them.
+    bool earlierMoments(double& mean, double& stddev) const;
+
+    // How many standard deviations the last amount lies from the mean of the
+    // amounts before it. 0 when there are fewer than MIN_ANOMALY_HISTORY of
+    // them; infinity when they were all equal and the last one differs.
+    double lastDeviation() const;
+
+    static TransactionStats of(const double* amounts, int count);
+
+    // Cheap check that saved statistics belong to `amounts`: same count, last
+    // amount, minimum and maximum, and a mean within rounding of theirs. Files
+    // that stored amounts with fewer digits than the statistics fail it.
+    bool describes(const double* amounts, int count) const;
+};
+
+// Earlier amounts needed before the last one is judged against them
+const int MIN_ANOMALY_HISTORY = 3;
+
+// Persisted after each account in .dat files as one optional line:
+//   @stats <deposit stats> <withdrawal stats>
+// where each group is "count mean m2 min max last largeCount earlierMean earlierM2"
+void writeStatsLine(std::ostream& os, const TransactionStats& deposits,
+                    const TransactionStats& withdrawals);
+
+// Parses a line written by writeStatsLine; returns false if it is malformed
+bool parseStatsLine(const char* text, size_t length, TransactionStats& deposits,
+                    TransactionStats& withdrawals);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TRANSFER_ENGINE_H
+#define TRANSFER_ENGINE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <cstddef>
+#include "BankAccount.h"
+#include "SnapshotRegistry.h"
+
+struct Transfer {
+    size_t fromIndex;        // Position of the debited account
+    size_t toIndex;          // Position of the credited account
+    double amount;           // Amount moved (finite and greater than zero)
+};
+
+struct Posting {
+    size_t accountIndex;     // Position of the account
+    bool deposit;            // False for a withdrawal
+    double amount;           // Finite and not negative
+};
+
+// Applies batches of transfers atomically: either every transfer in a batch
+// is posted or none is. Safe to call from several threads at once as long as
+// the accounts vector itself is not resized while batches are running.
+class TransferEngine {
+private:
+    static const size_t LOCK_STRIPES = 64;
+
+    std::vector<BankAccount>& accounts;
+    SnapshotRegistry* snapshots;      // Optional; receives one new version per batch
+    std::mutex stripes[LOCK_STRIPES]; // Account i is guarded by stripes[i % LOCK_STRIPES]
+    std::mutex journalMutex;
+    std::ofstream journal;
+    std::string journalPath;
+    unsigned long long nextBatchId;
+
+    void validateBatch(const std::vector<Transfer>& batch) const;
+    unsigned long long writeJournalRecord(const std::vector<Transfer>& batch);
+    std::vector<std::unique_lock<std::mutex>> lockAccounts(const std::vector<size_t>& touched);
+
+public:
+    explicit TransferEngine(std::vector<BankAccount>& accounts,
+                            SnapshotRegistry* snapshots = nullptr,
+                            const std::string& journalPath = "transfers.journal");
+
+    TransferEngine(const TransferEngine&) = delete;
+    TransferEngine& operator=(const TransferEngine&) = delete;
+
+    // Returns the id of the journal record written for the batch
+    unsigned long long applyBatch(const std::vector<Transfer>& batch);
+
+    // Posts single-sided deposits and withdrawals from an external feed,
+    // grouped per account under the same locks, and publishes one snapshot.
+    // Postings are not journaled; the feed itself is the record.
+    void applyPostings(const std::vector<Posting>& postings);
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "AccountIndex.h"
+#include <algorithm>
+#include "HeapBytes.h"
+
+std::string AccountIndex::fold(const char* text) {
+    std::string key(text);
+    for (char& c : key) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return key;
+}
+
+bool AccountIndex::entryLess(const Entry& a, const Entry& b) {
+    // Equal keys stay in account order so pages are stable
+    return a.key < b.key || (a.key == b.key && a.account < b.account);
+}
+
+void AccountIndex::insert(std::vector<Entry>& entries, const char* text, size_t account) {
+    Entry entry;
+    entry.key = fold(text);
+    entry.account = account;
+
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), entry, entryLess), entry);
+}
+
+void AccountIndex::range(const std::vector<Entry>& entries, const std::string& folded,
+                         EntryIterator& first, EntryIterator& last) {
+    const size_t length = folded.size();
+
+    // Keys compare by their first `length` characters only, so every key
+    // starting with the prefix lands in one contiguous range
+    first = std::lower_bound(entries.begin(), entries.end(), folded,
+        [length](const Entry& entry, const std::string& value) {
+            return entry.key.compare(0, length, value) < 0;
+        });
+    last = std::upper_bound(first, entries.end(), folded,
+        [length](const std::string& value, const Entry& entry) {
+            return entry.key.compare(0, length, value) > 0;
+        });
+}
+
+PrefixMatches AccountIndex::find(const std::vector<Entry>& entries, const std::string& prefix,
+                                 size_t offset, size_t limit) {
+    EntryIterator first, last;
+    range(entries, fold(prefix.c_str()), first, last);
+
+    PrefixMatches matches;
+    matches.total = static_cast<size_t>(last - first);
+    if (offset < matches.total) {
+        auto pageEnd = first + static_cast<std::ptrdiff_t>(std::min(matches.total, offset + limit));
+        for (auto it = first + static_cast<std::ptrdiff_t>(offset); it != pageEnd; ++it) {
+            matches.accounts.push_back(it->account);
+        }
+    }
+    return matches;
+}
+
+void AccountIndex::rebuild(const std::vector<BankAccount>& accounts) {
+    byCode.clear();
+    byOwner.clear();
+    byCode.reserve(accounts.size());
+    byOwner.reserve(accounts.size());
+
+    for (size_t i = 0; i < accounts.size(); ++i) {
+        Entry code = { fold(accounts[i].getUniqueCode()), i };
+        Entry owner = { fold(accounts[i].getOwnerName()), i };
+        byCode.push_back(code);
+        byOwner.push_back(owner);
+    }
+
+    std::sort(byCode.begin(), byCode.end(), entryLess);
+    std::sort(byOwner.begin(), byOwner.end(), entryLess);
+}
+
+void AccountIndex::add(const BankAccount& account, size_t position) {
+    insert(byCode, account.getUniqueCode(), position);
+    insert(byOwner, account.getOwnerName(), position);
+}
+
+size_t AccountIndex::size() const {
+    return byCode.size();
+}
+
+size_t AccountIndex::memoryUsage() const {
+    size_t bytes = (byCode.capacity() + byOwner.capacity()) * sizeof(Entry);
+    for (const auto& entry : byCode) bytes += heapBytes(entry.key);
+    for (const auto& entry : byOwner) bytes += heapBytes(entry.key);
+    return bytes;
+}
+
+PrefixMatches AccountIndex::findByCode(const std::string& prefix, size_t offset, size_t limit) const {
+    return find(byCode, prefix, offset, limit);
+}
+
+PrefixMatches AccountIndex::findByOwner(const std::string& prefix, size_t offset, size_t limit) const {
+    return find(byOwner, prefix, offset, limit);
+}
+
+PrefixMatches AccountIndex::findByCodeOrOwner(const std::vector<BankAccount>& accounts,
+                                              const std::string& prefix,
+                                              size_t offset, size_t limit) const {
+    const std::string folded = fold(prefix.c_str());
+    EntryIterator codesFirst, codesLast, ownersFirst, ownersLast;
+    range(byCode, folded, codesFirst, codesLast);
+    range(byOwner, folded, ownersFirst, ownersLast);
+
+    PrefixMatches matches;
+    matches.total = static_cast<size_t>(codesLast - codesFirst);
+    if (offset < matches.total) {
+        auto pageEnd = codesFirst + static_cast<std::ptrdiff_t>(std::min(matches.total, offset + limit));
+        for (auto it = codesFirst + static_cast<std::ptrdiff_t>(offset); it != pageEnd; ++it) {
+            matches.accounts.push_back(it->account);
+        }
+    }
+
+    const bool overlapPossible = codesFirst != codesLast;
+    for (auto it = ownersFirst; it != ownersLast; ++it) {
+        if (overlapPossible &&
+            fold(accounts[it->account].getUniqueCode()).compare(0, folded.size(), folded) == 0) {
+            continue; // Already listed with the code matches
+        }
+        if (matches.total >= offset && matches.accounts.size() < limit) {
+            matches.accounts.push_back(it->account);
+        }
+        ++matches.total;
+    }
+    return matches;
+}
+
+bool AccountIndex::findCode(const std::string& code, size_t& position) const {
+    const std::string folded = fold(code.c_str());
+    auto it = std::lower_bound(byCode.begin(), byCode.end(), folded,
+        [](const Entry& entry, const std::string& value) {
+            return entry.key < value;
+        });
+    if (it == byCode.end() || it->key != folded) {
+        return false;
+    }
+    position = it->account;
+    return true;
+}
@@ -0,0 +1,135 @@
+#include "AccountStorage.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include "DatReader.h"
+
+void saveAccountsFile(const std::string& filename, const std::vector<BankAccount>& accounts) {
+    // Binary mode keeps the checksummed bytes identical to what lands on disk
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create file");
+    }
+
+    ChecksumStreamBuf checksummed(file.rdbuf());
+    std::ostream out(&checksummed);
+
+    out << accounts.size() << "\n";
+    for (const auto& account : accounts) {
+        account.saveToFile(out);
+    }
+
+    if (!out || !checksummed.finish()) {
+        throw std::runtime_error("Cannot write file");
+    }
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Cannot write file");
+    }
+}
+
+namespace {
+
+void parseAccounts(DatReader& reader, std::vector<BankAccount>& accounts) {
+    unsigned long long accountCount = reader.nextAccountCount();
+    // The count is untrusted until the records are actually there; no record is shorter than 12 bytes
+    accounts.clear();
+    accounts.reserve(static_cast<size_t>(std::min(accountCount, reader.bytesRemaining() / 12)));
+
+    for (unsigned long long i = 0; i < accountCount; ++i) {
+        const char* text;
+        size_t length;
+
+        reader.nextCode(text, length);
+        std::unique_ptr<char[]> code(new char[length + 1]);
+        std::memcpy(code.get(), text, length);
+        code[length] = '\0';
+
+        reader.nextOwnerName(text, length);
+        std::unique_ptr<char[]> name(new char[length + 1]);
+        std::memcpy(name.get(), text, length);
+        name[length] = '\0';
+
+        int depositCount = reader.nextTransactionCount();
+        std::unique_ptr<double[]> deposits(new double[BankAccount::loadedCapacity(depositCount)]);
+        for (int j = 0; j < depositCount; ++j) {
+            deposits[j] = reader.nextAmount();
+        }
+
+        int withdrawalCount = reader.nextTransactionCount();
+        std::unique_ptr<double[]> withdrawals(new double[BankAccount::loadedCapacity(withdrawalCount)]);
+        for (int j = 0; j < withdrawalCount; ++j) {
+            withdrawals[j] = reader.nextAmount();
+        }
+
+        TransactionStats depositStats, withdrawalStats;
+        bool haveStats = reader.nextStats(depositStats, withdrawalStats);
+
+        accounts.push_back(BankAccount::fromLoadedState(code.release(), name.release(),
+                                                        deposits.release(), depositCount,
+                                                        withdrawals.release(), withdrawalCount,
+                                                        haveStats ? &depositStats : nullptr,
+                                                        haveStats ? &withdrawalStats : nullptr));
+    }
+}
+
+std::string corruptionMessage(const std::string& filename, const ChecksumReport& verification) {
+    std::ostringstream message;
+    message << "File \"" << filename << "\" is corrupted: ";
+    if (!verification.error.empty()) {
+        message << verification.error;
+    } else {
+        message << verification.badBlocks << " bad block(s), first is block "
+                << verification.firstBadBlock;
+    }
+    return message.str();
+}
+
+}
+
+bool loadAccountsFile(const std::string& filename, std::vector<BankAccount>& accounts,
+                      ChecksumReport* report) {
+    DatReader reader(filename);
+    if (!reader.isOpen()) {
+        return false;
+    }
+
+    // Blocks are checked as the parser reads them, so the file is read once
+    reader.beginVerification();
+    std::vector<BankAccount> loaded;
+    try {
+        parseAccounts(reader, loaded);
+    } catch (const std::runtime_error&) {
+        // A parse error caused by a damaged block is reported as the damage
+        ChecksumReport verification = reader.finishVerification();
+        if (report) {
+            *report = verification;
+        }
+        if (verification.hasChecksums && verification.badBlocks > 0) {
+            throw std::runtime_error(corruptionMessage(filename, verification));
+        }
+        throw;
+    }
+
+    ChecksumReport verification = reader.finishVerification();
+    if (report) {
+        *report = verification;
+    }
+    if (verification.hasChecksums && !verification.valid) {
+        throw std::runtime_error(corruptionMessage(filename, verification));
+    }
+
+    accounts.swap(loaded);
+    return true;
+}
+
+void parseAccountsFile(const std::string& filename, std::vector<BankAccount>& accounts) {
+    DatReader reader(filename);
+    if (!reader.isOpen()) {
+        throw std::runtime_error("Cannot open file");
+    }
+    parseAccounts(reader, accounts);
+}
@@ -0,0 +1,457 @@
+#include "AmountKernels.h"
+#include <vector>
+#include <sstream>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BANK_HAVE_X86_KERNELS 1
+#endif
+
+namespace {
+
+struct KernelTable {
+    const char* name;
+    double (*sum)(const double*, size_t);
+    size_t (*countAtLeast)(const double*, size_t, double);
+    size_t (*countEqual)(const double*, const double*, size_t);
+    void (*subtract)(const double*, const double*, double*, size_t);
+    void (*histogramIndices)(const double*, size_t, double, double, double, int*);
+};
+
+// Bin index shared by every implementation: clamp first, then truncate, so
+// vector and scalar code round identically (NaN goes to the first bin)
+inline int binIndex(double value, double lower, double inverseWidth, double lastBin) {
+    double t = (value - lower) * inverseWidth;
+    t = t > 0.0 ? t : 0.0;
+    t = t < lastBin ? t : lastBin;
+    return static_cast<int>(t);
+}
+
+// ---------------------------------------------------------------- scalar
+
+double sumScalar(const double* values, size_t count) {
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+size_t countAtLeastScalar(const double* values, size_t count, double threshold) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        matches += values[i] >= threshold;
+    }
+    return matches;
+}
+
+size_t countEqualScalar(const double* a, const double* b, size_t count) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        matches += a[i] == b[i];
+    }
+    return matches;
+}
+
+void subtractScalar(const double* a, const double* b, double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+void histogramIndicesScalar(const double* values, size_t count, double lower,
+                            double inverseWidth, double lastBin, int* indices) {
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = binIndex(values[i], lower, inverseWidth, lastBin);
+    }
+}
+
+const KernelTable SCALAR_KERNELS = {
+    "scalar", sumScalar, countAtLeastScalar, countEqualScalar, subtractScalar, histogramIndicesScalar
+};
+
+#ifdef BANK_HAVE_X86_KERNELS
+
+// ---------------------------------------------------------------- SSE2
+
+double sumSse2(const double* values, size_t count) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(values + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(values + i + 2));
+        acc2 = _mm_add_pd(acc2, _mm_loadu_pd(values + i + 4));
+        acc3 = _mm_add_pd(acc3, _mm_loadu_pd(values + i + 6));
+    }
+    __m128d acc = _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3));
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    double total = lanes[0] + lanes[1];
+    for (; i < count; ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+size_t countAtLeastSse2(const double* values, size_t count, double threshold) {
+    const __m128d limit = _mm_set1_pd(threshold);
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmpge_pd(_mm_loadu_pd(values + i), limit));
+        matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i < count; ++i) {
+        matches += values[i] >= threshold;
+    }
+    return matches;
+}
+
+size_t countEqualSse2(const double* a, const double* b, size_t count) {
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i < count; ++i) {
+        matches += a[i] == b[i];
+    }
+    return matches;
+}
+
+void subtractSse2(const double* a, const double* b, double* out, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    for (; i < count; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+void histogramIndicesSse2(const double* values, size_t count, double lower,
+                          double inverseWidth, double lastBin, int* indices) {
+    const __m128d base = _mm_set1_pd(lower), scale = _mm_set1_pd(inverseWidth);
+    const __m128d zero = _mm_setzero_pd(), top = _mm_set1_pd(lastBin);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d t = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(values + i), base), scale);
+        t = _mm_min_pd(_mm_max_pd(t, zero), top);
+        __m128i bins = _mm_cvttpd_epi32(t);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(indices + i), bins);
+    }
+    for (; i < count; ++i) {
+        indices[i] = binIndex(values[i], lower, inverseWidth, lastBin);
+    }
+}
+
+const KernelTable SSE2_KERNELS = {
+    "sse2", sumSse2, countAtLeastSse2, countEqualSse2, subtractSse2, histogramIndicesSse2
+};
+
+// ---------------------------------------------------------------- AVX2
+
+__attribute__((target("avx2")))
+double sumAvx2(const double* values, size_t count) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(values + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(values + i + 12));
+    }
+    __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t countAtLeastAvx2(const double* values, size_t count, double threshold) {
+    const __m256d limit = _mm256_set1_pd(threshold);
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), limit, _CMP_GE_OQ));
+        matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i < count; ++i) {
+        matches += values[i] >= threshold;
+    }
+    return matches;
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t countEqualAvx2(const double* a, const double* b, size_t count) {
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int mask = _mm256_movemask_pd(
+            _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _CMP_EQ_OQ));
+        matches += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i < count; ++i) {
+        matches += a[i] == b[i];
+    }
+    return matches;
+}
+
+__attribute__((target("avx2")))
+void subtractAvx2(const double* a, const double* b, double* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < count; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+void histogramIndicesAvx2(const double* values, size_t count, double lower,
+                          double inverseWidth, double lastBin, int* indices) {
+    const __m256d base = _mm256_set1_pd(lower), scale = _mm256_set1_pd(inverseWidth);
+    const __m256d zero = _mm256_setzero_pd(), top = _mm256_set1_pd(lastBin);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i), base), scale);
+        t = _mm256_min_pd(_mm256_max_pd(t, zero), top);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), _mm256_cvttpd_epi32(t));
+    }
+    for (; i < count; ++i) {
+        indices[i] = binIndex(values[i], lower, inverseWidth, lastBin);
+    }
+}
+
+const KernelTable AVX2_KERNELS = {
+    "avx2", sumAvx2, countAtLeastAvx2, countEqualAvx2, subtractAvx2, histogramIndicesAvx2
+};
+
+// ---------------------------------------------------------------- AVX-512
+
+// GCC 12's AVX-512 headers trip its own uninitialized-value warnings
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f")))
+double sumAvx512(const double* values, size_t count) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(values + i));
+        acc1 = _mm512_add_pd(acc1, _mm512_loadu_pd(values + i + 8));
+        acc2 = _mm512_add_pd(acc2, _mm512_loadu_pd(values + i + 16));
+        acc3 = _mm512_add_pd(acc3, _mm512_loadu_pd(values + i + 24));
+    }
+    double total = _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1),
+                                                      _mm512_add_pd(acc2, acc3)));
+    for (; i < count; ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+__attribute__((target("avx512f,popcnt")))
+size_t countAtLeastAvx512(const double* values, size_t count, double threshold) {
+    const __m512d limit = _mm512_set1_pd(threshold);
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __mmask8 mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), limit, _CMP_GE_OQ);
+        matches += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    for (; i < count; ++i) {
+        matches += values[i] >= threshold;
+    }
+    return matches;
+}
+
+__attribute__((target("avx512f,popcnt")))
+size_t countEqualAvx512(const double* a, const double* b, size_t count) {
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __mmask8 mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), _CMP_EQ_OQ);
+        matches += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    for (; i < count; ++i) {
+        matches += a[i] == b[i];
+    }
+    return matches;
+}
+
+__attribute__((target("avx512f")))
+void subtractAvx512(const double* a, const double* b, double* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+    }
+    for (; i < count; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+__attribute__((target("avx512f")))
+void histogramIndicesAvx512(const double* values, size_t count, double lower,
+                            double inverseWidth, double lastBin, int* indices) {
+    const __m512d base = _mm512_set1_pd(lower), scale = _mm512_set1_pd(inverseWidth);
+    const __m512d zero = _mm512_setzero_pd(), top = _mm512_set1_pd(lastBin);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d t = _mm512_mul_pd(_mm512_sub_pd(_mm512_loadu_pd(values + i), base), scale);
+        t = _mm512_min_pd(_mm512_max_pd(t, zero), top);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices + i), _mm512_cvttpd_epi32(t));
+    }
+    for (; i < count; ++i) {
+        indices[i] = binIndex(values[i], lower, inverseWidth, lastBin);
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+const KernelTable AVX512_KERNELS = {
+    "avx512", sumAvx512, countAtLeastAvx512, countEqualAvx512, subtractAvx512, histogramIndicesAvx512
+};
+
+#endif
+
+// Every implementation usable on this CPU, widest first
+std::vector<const KernelTable*> supportedKernels() {
+    std::vector<const KernelTable*> tables;
+#ifdef BANK_HAVE_X86_KERNELS
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt")) {
+        tables.push_back(&AVX512_KERNELS);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        tables.push_back(&AVX2_KERNELS);
+    }
+    tables.push_back(&SSE2_KERNELS);
+#endif
+    tables.push_back(&SCALAR_KERNELS);
+    return tables;
+}
+
+const KernelTable* activeKernels() {
+    static const KernelTable* const table = supportedKernels().front();
+    return table;
+}
+
+void histogramWith(const KernelTable& kernels, const double* values, size_t count,
+                   double lower, double width, size_t binCount, size_t* bins) {
+    if (binCount == 0) {
+        return;
+    }
+    const double inverseWidth = width > 0 ? 1.0 / width : 0.0;
+    const double lastBin = static_cast<double>(binCount - 1);
+
+    // Indices are computed a chunk at a time in vector registers; only the increments are scalar
+    const size_t CHUNK = 1024;
+    int indices[CHUNK];
+    for (size_t start = 0; start < count; start += CHUNK) {
+        size_t size = count - start < CHUNK ? count - start : CHUNK;
+        kernels.histogramIndices(values + start, size, lower, inverseWidth, lastBin, indices);
+        for (size_t i = 0; i < size; ++i) {
+            ++bins[indices[i]];
+        }
+    }
+}
+
+}
+
+double sumAmounts(const double* values, size_t count) {
+    return activeKernels()->sum(values, count);
+}
+
+size_t countAtLeast(const double* values, size_t count, double threshold) {
+    return activeKernels()->countAtLeast(values, count, threshold);
+}
+
+size_t countEqual(const double* a, const double* b, size_t count) {
+    return activeKernels()->countEqual(a, b, count);
+}
+
+void subtractAmounts(const double* a, const double* b, double* out, size_t count) {
+    activeKernels()->subtract(a, b, out, count);
+}
+
+void histogramAmounts(const double* values, size_t count, double lower, double width,
+                      size_t binCount, size_t* bins) {
+    // Bin indices are computed as 32-bit integers
+    if (binCount > MAX_HISTOGRAM_BINS) {
+        throw std::invalid_argument("Too many histogram bins");
+    }
+    histogramWith(*activeKernels(), values, count, lower, width, binCount, bins);
+}
+
+const char* amountKernelsImplementation() {
+    return activeKernels()->name;
+}
+
+bool verifyAmountKernels(std::string& failure) {
+    // Deterministic amounts with a few repeats so equality counts are non-trivial
+    const size_t LENGTHS[] = { 0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 1000, 100003 };
+    std::vector<double> a(100003), b(100003);
+    unsigned long long state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < a.size(); ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        a[i] = static_cast<double>(state >> 40) / 100.0;
+        b[i] = (i % 3 == 0) ? a[i] : a[i] + 0.01;
+    }
+
+    const std::vector<const KernelTable*> tables = supportedKernels();
+    for (const KernelTable* kernels : tables) {
+        for (size_t length : LENGTHS) {
+            std::ostringstream where;
+            where << kernels->name << ", " << length << " values: ";
+
+            double expected = sumScalar(a.data(), length);
+            double actual = kernels->sum(a.data(), length);
+            // All amounts are non-negative, so the sum is also their magnitude
+            if (std::fabs(actual - expected) > 1e-12 * expected + 1e-9) {
+                failure = where.str() + "sum differs";
+                return false;
+            }
+            if (kernels->countAtLeast(a.data(), length, 5e4) != countAtLeastScalar(a.data(), length, 5e4)) {
+                failure = where.str() + "threshold count differs";
+                return false;
+            }
+            if (kernels->countEqual(a.data(), b.data(), length) != countEqualScalar(a.data(), b.data(), length)) {
+                failure = where.str() + "equality count differs";
+                return false;
+            }
+
+            std::vector<double> expectedDiff(length), actualDiff(length);
+            subtractScalar(a.data(), b.data(), expectedDiff.data(), length);
+            kernels->subtract(a.data(), b.data(), actualDiff.data(), length);
+            if (expectedDiff != actualDiff) {
+                failure = where.str() + "differences differ";
+                return false;
+            }
+
+            std::vector<size_t> expectedBins(16), actualBins(16);
+            histogramWith(SCALAR_KERNELS, a.data(), length, 1000.0, 10000.0, 16, expectedBins.data());
+            histogramWith(*kernels, a.data(), length, 1000.0, 10000.0, 16, actualBins.data());
+            if (expectedBins != actualBins) {
+                failure = where.str() + "histogram differs";
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#include "AnomalyReport.h"
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+namespace {
+
+void check(size_t position, bool deposit, const TransactionStats& stats, double threshold,
+           std::vector<Anomaly>& found) {
+    double deviation = stats.lastDeviation();
+    if (deviation <= threshold) {
+        return;
+    }
+    Anomaly anomaly;
+    anomaly.account = position;
+    anomaly.deposit = deposit;
+    anomaly.last = stats.last;
+    stats.earlierMoments(anomaly.earlierMean, anomaly.earlierStddev);
+    anomaly.deviation = deviation;
+    found.push_back(anomaly);
+}
+
+}
+
+std::vector<Anomaly> findAnomalies(const BookSnapshot& book, double threshold) {
+    std::vector<Anomaly> found;
+    for (size_t i = 0; i < book.size(); ++i) {
+        const AccountSnapshot& account = book[i];
+        check(i, true, account.depositStats, threshold, found);
+        check(i, false, account.withdrawalStats, threshold, found);
+    }
+    std::stable_sort(found.begin(), found.end(), [](const Anomaly& a, const Anomaly& b) {
+        return a.deviation > b.deviation;
+    });
+    return found;
+}
+
+void printAnomalies(const BookSnapshot& book, const std::vector<Anomaly>& anomalies,
+                    size_t limit, std::ostream& out) {
+    out << std::left << std::setw(8) << "Code" << std::setw(22) << "Owner" << std::setw(11) << "Type"
+        << std::right << std::setw(14) << "Last" << std::setw(14) << "Earlier mean"
+        << std::setw(12) << "Std dev" << std::setw(9) << "Sigmas" << std::setw(7) << "Large" << "\n";
+    out << std::string(97, '-') << "\n";
+
+    out << std::fixed;
+    for (size_t i = 0; i < anomalies.size() && i < limit; ++i) {
+        const Anomaly& anomaly = anomalies[i];
+        const AccountSnapshot& account = book[anomaly.account];
+        const TransactionStats& stats = anomaly.deposit ? account.depositStats : account.withdrawalStats;
+
+        out << std::left << std::setw(8) << account.getUniqueCode()
+            << std::setw(22) << account.getOwnerName().substr(0, 21)
+            << std::setw(11) << (anomaly.deposit ? "deposit" : "withdrawal") << std::right
+            << std::setprecision(2) << std::setw(14) << anomaly.last << " " << std::setw(13) << anomaly.earlierMean
+            << " " << std::setw(11) << anomaly.earlierStddev << std::setw(9);
+        if (std::isinf(anomaly.deviation)) {
+            out << "inf";
+        } else {
+            out << std::setprecision(1) << anomaly.deviation;
+        }
+        out << std::setw(7) << stats.largeCount << "\n";
+    }
+    if (anomalies.size() > limit) {
+        out << "... " << (anomalies.size() - limit) << " more\n";
+    }
+    out << anomalies.size() << " unusual transactions in " << book.size() << " accounts\n";
+}
@@ -3,6 +3,26 @@
 #include <iomanip>
 #include <cctype>
 #include <limits>
+#include <utility>
+#include <string>
+#include <algorithm>
+#include "DatReader.h"
+
+namespace {
+
+const int GEOMETRIC_GROWTH_LIMIT = 1024; // Arrays this long grow by half instead of doubling
+const int MIN_LOAD_HEADROOM = 2;
+
+// Next capacity for a full array. Long histories grow by half so at most a
+// third of their array is ever unused.
+int grownCapacity(int capacity) {
+    if (capacity < 2) {
+        return 2;
+    }
+    return capacity < GEOMETRIC_GROWTH_LIMIT ? capacity * 2 : capacity + capacity / 2;
+}
+
+}
 
 void BankAccount::validateUniqueCode(const char* code) const {
     if (!code || strlen(code) != 6) {
@@ -28,7 +48,7 @@ void BankAccount::validateOwnerName(const char* name) const {
 
 void BankAccount::resizeDepositedArray() {
     if (depositedCount >= depositedCapacity) {
-        int newCapacity = depositedCapacity == 0 ? 2 : depositedCapacity * 2;
+        int newCapacity = grownCapacity(depositedCapacity);
         double* newArray = new double[newCapacity];
         
         for (int i = 0; i < depositedCount; ++i) {
@@ -43,7 +63,7 @@ void BankAccount::resizeDepositedArray() {
 
 void BankAccount::resizeWithdrawnArray() {
     if (withdrawnCount >= withdrawnCapacity) {
-        int newCapacity = withdrawnCapacity == 0 ? 2 : withdrawnCapacity * 2;
+        int newCapacity = grownCapacity(withdrawnCapacity);
         double* newArray = new double[newCapacity];
         
         for (int i = 0; i < withdrawnCount; ++i) {
@@ -60,17 +80,27 @@ BankAccount::BankAccount()
     : uniqueCode(nullptr), ownerName(nullptr),
       depositedAmounts(nullptr), withdrawnAmounts(nullptr),
       depositedCount(0), withdrawnCount(0),
-      depositedCapacity(0), withdrawnCapacity(0) {
+      depositedCapacity(0), withdrawnCapacity(0), depositedTotal(0.0), withdrawnTotal(0.0),
+      recentTransactions(0), compactedSinceLoad(false), unsavedChanges(true) {
     uniqueCode = new char[7];
     strcpy(uniqueCode, "A00000");
     ownerName = new char[1];
     ownerName[0] = '\0';
 }
 
+BankAccount::BankAccount(std::nullptr_t)
+    : uniqueCode(nullptr), ownerName(nullptr),
+      depositedAmounts(nullptr), withdrawnAmounts(nullptr),
+      depositedCount(0), withdrawnCount(0),
+      depositedCapacity(0), withdrawnCapacity(0), depositedTotal(0.0), withdrawnTotal(0.0),
+      recentTransactions(0), compactedSinceLoad(false), unsavedChanges(true) {
+}
+
 BankAccount::BankAccount(const char* uniqueCode, const char* ownerName)
     : depositedAmounts(nullptr), withdrawnAmounts(nullptr),
       depositedCount(0), withdrawnCount(0),
-      depositedCapacity(0), withdrawnCapacity(0) {
+      depositedCapacity(0), withdrawnCapacity(0), depositedTotal(0.0), withdrawnTotal(0.0),
+      recentTransactions(0), compactedSinceLoad(false), unsavedChanges(true) {
     validateUniqueCode(uniqueCode);
     validateOwnerName(ownerName);
     
@@ -83,13 +113,17 @@ BankAccount::BankAccount(const char* uniqueCode, const char* ownerName)
 
 BankAccount::BankAccount(const BankAccount& other)
     : depositedCount(other.depositedCount), withdrawnCount(other.withdrawnCount),
-      depositedCapacity(other.depositedCapacity), withdrawnCapacity(other.withdrawnCapacity) {
+      depositedCapacity(other.depositedCapacity), withdrawnCapacity(other.withdrawnCapacity),
+      depositedTotal(other.depositedTotal), withdrawnTotal(other.withdrawnTotal),
+      depositStats(other.depositStats), withdrawalStats(other.withdrawalStats),
+      recentTransactions(other.recentTransactions), compactedSinceLoad(other.compactedSinceLoad),
+      unsavedChanges(other.unsavedChanges) {
     
-    uniqueCode = new char[strlen(other.uniqueCode) + 1];
-    strcpy(uniqueCode, other.uniqueCode);
+    uniqueCode = new char[strlen(other.getUniqueCode()) + 1];
+    strcpy(uniqueCode, other.getUniqueCode());
     
-    ownerName = new char[strlen(other.ownerName) + 1];
-    strcpy(ownerName, other.ownerName);
+    ownerName = new char[strlen(other.getOwnerName()) + 1];
+    strcpy(ownerName, other.getOwnerName());
     
     depositedAmounts = new double[depositedCapacity];
     for (int i = 0; i < depositedCount; ++i) {
@@ -102,6 +136,28 @@ BankAccount::BankAccount(const BankAccount& other)
     }
 }
 
+BankAccount::BankAccount(BankAccount&& other) noexcept
+    : uniqueCode(other.uniqueCode), ownerName(other.ownerName),
+      depositedAmounts(other.depositedAmounts), withdrawnAmounts(other.withdrawnAmounts),
+      depositedCount(other.depositedCount), withdrawnCount(other.withdrawnCount),
+      depositedCapacity(other.depositedCapacity), withdrawnCapacity(other.withdrawnCapacity),
+      depositedTotal(other.depositedTotal), withdrawnTotal(other.withdrawnTotal),
+      depositStats(other.depositStats), withdrawalStats(other.withdrawalStats),
+      recentTransactions(other.recentTransactions), compactedSinceLoad(other.compactedSinceLoad),
+      unsavedChanges(other.unsavedChanges) {
+    other.uniqueCode = nullptr;
+    other.ownerName = nullptr;
+    other.depositedAmounts = nullptr;
+    other.withdrawnAmounts = nullptr;
+    other.depositedCount = other.withdrawnCount = 0;
+    other.depositedCapacity = other.withdrawnCapacity = 0;
+    other.depositedTotal = other.withdrawnTotal = 0.0;
+    other.depositStats = other.withdrawalStats = TransactionStats();
+    other.recentTransactions = 0;
+    other.compactedSinceLoad = false;
+    other.unsavedChanges = true;
+}
+
 BankAccount::~BankAccount() {
     delete[] uniqueCode;
     delete[] ownerName;
@@ -110,11 +166,11 @@ BankAccount::~BankAccount() {
 }
 
 const char* BankAccount::getUniqueCode() const {
-    return uniqueCode;
+    return uniqueCode ? uniqueCode : "";
 }
 
 const char* BankAccount::getOwnerName() const {
-    return ownerName;
+    return ownerName ? ownerName : "";
 }
 
 int BankAccount::getDepositedCount() const {
@@ -125,31 +181,70 @@ int BankAccount::getWithdrawnCount() const {
     return withdrawnCount;
 }
 
-double BankAccount::getTotalDeposited() const {
-    double total = 0.0;
-    for (int i = 0; i < depositedCount; ++i) {
-        total += depositedAmounts[i];
+double BankAccount::getDepositedAmount(int index) const {
+    if (index < 0 || index >= depositedCount) {
+        throw std::out_of_range("Deposit index out of range");
     }
-    return total;
+    return depositedAmounts[index];
 }
 
-double BankAccount::getTotalWithdrawn() const {
-    double total = 0.0;
-    for (int i = 0; i < withdrawnCount; ++i) {
-        total += withdrawnAmounts[i];
+double BankAccount::getWithdrawnAmount(int index) const {
+    if (index < 0 || index >= withdrawnCount) {
+        throw std::out_of_range("Withdrawal index out of range");
     }
-    return total;
+    return withdrawnAmounts[index];
+}
+
+double BankAccount::getTotalDeposited() const {
+    return depositedTotal;
+}
+
+double BankAccount::getTotalWithdrawn() const {
+    return withdrawnTotal;
 }
 
 double BankAccount::getBalance() const {
     return getTotalDeposited() - getTotalWithdrawn();
 }
 
+const TransactionStats& BankAccount::getDepositStats() const {
+    return depositStats;
+}
+
+const TransactionStats& BankAccount::getWithdrawalStats() const {
+    return withdrawalStats;
+}
+
+int BankAccount::getDepositedCapacity() const {
+    return depositedCapacity;
+}
+
+int BankAccount::getWithdrawnCapacity() const {
+    return withdrawnCapacity;
+}
+
+int BankAccount::getRecentTransactions() const {
+    return recentTransactions;
+}
+
+bool BankAccount::hasUnsavedChanges() const {
+    return unsavedChanges;
+}
+
+bool BankAccount::isDormant() const {
+    return compactedSinceLoad && recentTransactions == 0;
+}
+
+int BankAccount::loadedCapacity(int count) {
+    return count == 0 ? 0 : count + std::max(MIN_LOAD_HEADROOM, count / 8);
+}
+
 void BankAccount::setUniqueCode(const char* code) {
     validateUniqueCode(code);
     delete[] uniqueCode;
     uniqueCode = new char[strlen(code) + 1];
     strcpy(uniqueCode, code);
+    unsavedChanges = true;
 }
 
 void BankAccount::setOwnerName(const char* name) {
@@ -157,6 +252,11 @@ void BankAccount::setOwnerName(const char* name) {
     delete[] ownerName;
     ownerName = new char[strlen(name) + 1];
     strcpy(ownerName, name);
+    unsavedChanges = true;
+}
+
+void BankAccount::setUnsavedChanges(bool unsaved) {
+    unsavedChanges = unsaved;
 }
 
 void BankAccount::addDeposit(double amount) {
@@ -165,6 +265,10 @@ void BankAccount::addDeposit(double amount) {
     }
     resizeDepositedArray();
     depositedAmounts[depositedCount++] = amount;
+    depositedTotal += amount;
+    depositStats.add(amount);
+    ++recentTransactions;
+    unsavedChanges = true;
 }
 
 void BankAccount::addWithdrawal(double amount) {
@@ -173,6 +277,85 @@ void BankAccount::addWithdrawal(double amount) {
     }
     resizeWithdrawnArray();
     withdrawnAmounts[withdrawnCount++] = amount;
+    withdrawnTotal += amount;
+    withdrawalStats.add(amount);
+    ++recentTransactions;
+    unsavedChanges = true;
+}
+
+void BankAccount::reserveTransactions(int extraDeposits, int extraWithdrawals) {
+    if (extraDeposits < 0 || extraWithdrawals < 0) {
+        throw std::invalid_argument("Reserved transaction count cannot be negative");
+    }
+    
+    // Allocate both arrays before touching either so a failure leaves the account unchanged
+    double* newDeposited = nullptr;
+    double* newWithdrawn = nullptr;
+    int newDepositedCapacity = depositedCapacity;
+    int newWithdrawnCapacity = withdrawnCapacity;
+    
+    // Grow at least as much as single appends would, so repeated small reservations stay amortized
+    if (depositedCount + extraDeposits > depositedCapacity) {
+        newDepositedCapacity = std::max(depositedCount + extraDeposits, grownCapacity(depositedCapacity));
+        newDeposited = new double[newDepositedCapacity];
+    }
+    if (withdrawnCount + extraWithdrawals > withdrawnCapacity) {
+        newWithdrawnCapacity = std::max(withdrawnCount + extraWithdrawals, grownCapacity(withdrawnCapacity));
+        try {
+            newWithdrawn = new double[newWithdrawnCapacity];
+        } catch (...) {
+            delete[] newDeposited;
+            throw;
+        }
+    }
+    
+    if (newDeposited) {
+        for (int i = 0; i < depositedCount; ++i) {
+            newDeposited[i] = depositedAmounts[i];
+        }
+        delete[] depositedAmounts;
+        depositedAmounts = newDeposited;
+        depositedCapacity = newDepositedCapacity;
+    }
+    if (newWithdrawn) {
+        for (int i = 0; i < withdrawnCount; ++i) {
+            newWithdrawn[i] = withdrawnAmounts[i];
+        }
+        delete[] withdrawnAmounts;
+        withdrawnAmounts = newWithdrawn;
+        withdrawnCapacity = newWithdrawnCapacity;
+    }
+}
+
+bool BankAccount::compact() {
+    const bool trim = isDormant();
+    recentTransactions = 0;
+    compactedSinceLoad = true;
+    if (!trim || (depositedCapacity == depositedCount && withdrawnCapacity == withdrawnCount)) {
+        return trim;
+    }
+    
+    // Allocate both arrays before touching either so a failure leaves the account unchanged
+    double* newDeposited = depositedCount > 0 ? new double[depositedCount] : nullptr;
+    double* newWithdrawn = nullptr;
+    if (withdrawnCount > 0) {
+        try {
+            newWithdrawn = new double[withdrawnCount];
+        } catch (...) {
+            delete[] newDeposited;
+            throw;
+        }
+    }
+    
+    std::copy(depositedAmounts, depositedAmounts + depositedCount, newDeposited);
+    delete[] depositedAmounts;
+    depositedAmounts = newDeposited;
+    depositedCapacity = depositedCount;
+    std::copy(withdrawnAmounts, withdrawnAmounts + withdrawnCount, newWithdrawn);
+    delete[] withdrawnAmounts;
+    withdrawnAmounts = newWithdrawn;
+    withdrawnCapacity = withdrawnCount;
+    return trim;
 }
 
 bool BankAccount::hasEqualDepositsAndWithdrawals() const {
@@ -186,16 +369,23 @@ BankAccount& BankAccount::operator=(const BankAccount& other) {
         delete[] depositedAmounts;
         delete[] withdrawnAmounts;
         
-        uniqueCode = new char[strlen(other.uniqueCode) + 1];
-        strcpy(uniqueCode, other.uniqueCode);
+        uniqueCode = new char[strlen(other.getUniqueCode()) + 1];
+        strcpy(uniqueCode, other.getUniqueCode());
         
-        ownerName = new char[strlen(other.ownerName) + 1];
-        strcpy(ownerName, other.ownerName);
+        ownerName = new char[strlen(other.getOwnerName()) + 1];
+        strcpy(ownerName, other.getOwnerName());
         
         depositedCount = other.depositedCount;
         withdrawnCount = other.withdrawnCount;
         depositedCapacity = other.depositedCapacity;
         withdrawnCapacity = other.withdrawnCapacity;
+        depositedTotal = other.depositedTotal;
+        withdrawnTotal = other.withdrawnTotal;
+        depositStats = other.depositStats;
+        withdrawalStats = other.withdrawalStats;
+        recentTransactions = other.recentTransactions;
+        compactedSinceLoad = other.compactedSinceLoad;
+        unsavedChanges = other.unsavedChanges;
         
         depositedAmounts = new double[depositedCapacity];
         for (int i = 0; i < depositedCount; ++i) {
@@ -210,9 +400,30 @@ BankAccount& BankAccount::operator=(const BankAccount& other) {
     return *this;
 }
 
+BankAccount& BankAccount::operator=(BankAccount&& other) noexcept {
+    if (this != &other) {
+        std::swap(uniqueCode, other.uniqueCode);
+        std::swap(ownerName, other.ownerName);
+        std::swap(depositedAmounts, other.depositedAmounts);
+        std::swap(withdrawnAmounts, other.withdrawnAmounts);
+        std::swap(depositedCount, other.depositedCount);
+        std::swap(withdrawnCount, other.withdrawnCount);
+        std::swap(depositedCapacity, other.depositedCapacity);
+        std::swap(withdrawnCapacity, other.withdrawnCapacity);
+        std::swap(depositedTotal, other.depositedTotal);
+        std::swap(withdrawnTotal, other.withdrawnTotal);
+        std::swap(depositStats, other.depositStats);
+        std::swap(withdrawalStats, other.withdrawalStats);
+        std::swap(recentTransactions, other.recentTransactions);
+        std::swap(compactedSinceLoad, other.compactedSinceLoad);
+        std::swap(unsavedChanges, other.unsavedChanges);
+    }
+    return *this;
+}
+
 std::ostream& operator<<(std::ostream& os, const BankAccount& account) {
-    os << "Account Code: " << account.uniqueCode << "\n";
-    os << "Owner: " << account.ownerName << "\n";
+    os << "Account Code: " << account.getUniqueCode() << "\n";
+    os << "Owner: " << account.getOwnerName() << "\n";
     os << "Deposits Count: " << account.depositedCount << "\n";
     os << "Withdrawals Count: " << account.withdrawnCount << "\n";
     
@@ -268,25 +479,31 @@ std::istream& operator>>(std::istream& is, BankAccount& account) {
 }
 
 void BankAccount::saveToFile(std::ostream& os) const {
-    os << uniqueCode << "\n";
-    os << ownerName << "\n";
+    // Amounts are written so they read back exactly, matching the saved statistics
+    char text[32];
+    os << getUniqueCode() << "\n";
+    os << getOwnerName() << "\n";
     os << depositedCount << "\n";
     for (int i = 0; i < depositedCount; ++i) {
-        os << depositedAmounts[i] << "\n";
+        os.write(text, static_cast<std::streamsize>(formatAmount(depositedAmounts[i], text))) << "\n";
     }
     os << withdrawnCount << "\n";
     for (int i = 0; i < withdrawnCount; ++i) {
-        os << withdrawnAmounts[i] << "\n";
+        os.write(text, static_cast<std::streamsize>(formatAmount(withdrawnAmounts[i], text))) << "\n";
     }
+    writeStatsLine(os, depositStats, withdrawalStats);
 }
 
 void BankAccount::loadFromFile(std::istream& is) {
     char code[10];
     char name[256];
     
-    is >> code;
+    is >> std::setw(sizeof(code)) >> code;
     is.ignore();
     is.getline(name, 256);
+    if (!is) {
+        throw std::runtime_error("Corrupted account record: bad code or owner name");
+    }
     
     delete[] uniqueCode;
     delete[] ownerName;
@@ -295,21 +512,84 @@ void BankAccount::loadFromFile(std::istream& is) {
     ownerName = new char[strlen(name) + 1];
     strcpy(ownerName, name);
     
-    is >> depositedCount;
+    // Counts are checked before allocating so a damaged file cannot request huge arrays
+    int count;
+    if (!(is >> count) || count < 0) {
+        throw std::runtime_error("Corrupted account record: bad deposit count");
+    }
     delete[] depositedAmounts;
-    depositedAmounts = new double[depositedCount];
-    depositedCapacity = depositedCount;
-    for (int i = 0; i < depositedCount; ++i) {
-        is >> depositedAmounts[i];
+    depositedAmounts = nullptr;
+    depositedCount = depositedCapacity = 0;
+    depositedTotal = 0.0;
+    depositedAmounts = new double[loadedCapacity(count)];
+    depositedCapacity = loadedCapacity(count);
+    for (int i = 0; i < count; ++i) {
+        if (!(is >> depositedAmounts[i])) {
+            throw std::runtime_error("Corrupted account record: bad deposit amount");
+        }
+        depositedCount = i + 1;
+        depositedTotal += depositedAmounts[i];
     }
     
-    is >> withdrawnCount;
+    if (!(is >> count) || count < 0) {
+        throw std::runtime_error("Corrupted account record: bad withdrawal count");
+    }
     delete[] withdrawnAmounts;
-    withdrawnAmounts = new double[withdrawnCount];
-    withdrawnCapacity = withdrawnCount;
-    for (int i = 0; i < withdrawnCount; ++i) {
-        is >> withdrawnAmounts[i];
+    withdrawnAmounts = nullptr;
+    withdrawnCount = withdrawnCapacity = 0;
+    withdrawnTotal = 0.0;
+    withdrawnAmounts = new double[loadedCapacity(count)];
+    withdrawnCapacity = loadedCapacity(count);
+    for (int i = 0; i < count; ++i) {
+        if (!(is >> withdrawnAmounts[i])) {
+            throw std::runtime_error("Corrupted account record: bad withdrawal amount");
+        }
+        withdrawnCount = i + 1;
+        withdrawnTotal += withdrawnAmounts[i];
     }
-    is.ignore();
+    
+    // Files written before statistics existed have no @stats line
+    TransactionStats savedDeposits, savedWithdrawals;
+    std::string statsLine;
+    if ((is >> std::ws).peek() == '@' && std::getline(is, statsLine) &&
+        parseStatsLine(statsLine.data(), statsLine.size(), savedDeposits, savedWithdrawals) &&
+        savedDeposits.describes(depositedAmounts, depositedCount) &&
+        savedWithdrawals.describes(withdrawnAmounts, withdrawnCount)) {
+        depositStats = savedDeposits;
+        withdrawalStats = savedWithdrawals;
+    } else {
+        depositStats = TransactionStats::of(depositedAmounts, depositedCount);
+        withdrawalStats = TransactionStats::of(withdrawnAmounts, withdrawnCount);
+    }
+    recentTransactions = 0;
+    compactedSinceLoad = false;
+    unsavedChanges = false;
 }
 
+BankAccount BankAccount::fromLoadedState(char* code, char* name,
+                                         double* deposits, int depositCount,
+                                         double* withdrawals, int withdrawalCount,
+                                         const TransactionStats* savedDepositStats,
+                                         const TransactionStats* savedWithdrawalStats) {
+    BankAccount account(nullptr);
+    account.uniqueCode = code;
+    account.ownerName = name;
+    account.depositedAmounts = deposits;
+    account.withdrawnAmounts = withdrawals;
+    account.depositedCount = depositCount;
+    account.depositedCapacity = loadedCapacity(depositCount);
+    account.withdrawnCount = withdrawalCount;
+    account.withdrawnCapacity = loadedCapacity(withdrawalCount);
+    for (int i = 0; i < depositCount; ++i) {
+        account.depositedTotal += deposits[i];
+    }
+    for (int i = 0; i < withdrawalCount; ++i) {
+        account.withdrawnTotal += withdrawals[i];
+    }
+    account.depositStats = savedDepositStats && savedDepositStats->describes(deposits, depositCount)
+        ? *savedDepositStats : TransactionStats::of(deposits, depositCount);
+    account.withdrawalStats = savedWithdrawalStats && savedWithdrawalStats->describes(withdrawals, withdrawalCount)
+        ? *savedWithdrawalStats : TransactionStats::of(withdrawals, withdrawalCount);
+    account.unsavedChanges = false;
+    return account;
+}
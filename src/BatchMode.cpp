@@ -0,0 +1,278 @@
+#include "BatchMode.h"
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include "AccountStorage.h"
+#include "AmountKernels.h"
+#include "DataExchange.h"
+#include "ShardedStorage.h"
+#include "IngestPipeline.h"
+#include "AnomalyReport.h"
+#include "MemoryReport.h"
+
+namespace {
+
+const size_t FIND_LIMIT = 100;
+
+size_t findAccount(const AccountIndex& index, const std::string& code) {
+    size_t position;
+    if (!index.findCode(code, position)) {
+        throw std::invalid_argument("Unknown account code: " + code);
+    }
+    return position;
+}
+
+void printMatches(const std::vector<BankAccount>& accounts, const PrefixMatches& matches, std::ostream& out) {
+    for (size_t position : matches.accounts) {
+        const BankAccount& account = accounts[position];
+        out << account.getUniqueCode() << " " << account.getOwnerName() << "\n";
+    }
+    out << matches.accounts.size() << " of " << matches.total << " matches\n";
+}
+
+void printBookStats(const BookSnapshot& snapshot, size_t binCount, std::ostream& out) {
+    std::vector<double> deposited, withdrawn, balances(snapshot.size());
+    snapshot.collectTotals(deposited, withdrawn);
+    subtractAmounts(deposited.data(), withdrawn.data(), balances.data(), balances.size());
+
+    out << std::fixed << std::setprecision(2)
+        << "Accounts:        " << snapshot.size() << "\n"
+        << "Total deposited: " << sumAmounts(deposited.data(), deposited.size()) << " BGN\n"
+        << "Total withdrawn: " << sumAmounts(withdrawn.data(), withdrawn.size()) << " BGN\n"
+        << "Net balance:     " << sumAmounts(balances.data(), balances.size()) << " BGN\n"
+        << "Equal deposits and withdrawals: "
+        << countEqual(deposited.data(), withdrawn.data(), deposited.size()) << "\n";
+
+    if (balances.empty()) {
+        return;
+    }
+    auto range = std::minmax_element(balances.begin(), balances.end());
+    double lower = *range.first;
+    double width = (*range.second - lower) / static_cast<double>(binCount);
+    std::vector<size_t> bins(binCount);
+    histogramAmounts(balances.data(), balances.size(), lower, width, binCount, bins.data());
+
+    out << "Balance histogram (" << amountKernelsImplementation() << "):\n";
+    for (size_t i = 0; i < binCount; ++i) {
+        out << "  [" << std::setw(14) << lower + width * static_cast<double>(i) << ", "
+            << std::setw(14) << lower + width * static_cast<double>(i + 1) << ") "
+            << bins[i] << "\n";
+    }
+}
+
+void printImportResult(const ImportResult& result, std::ostream& out) {
+    out << "[OK] Imported " << result.imported << ", rejected " << result.rejected << "\n";
+    for (const auto& error : result.errors) {
+        out << "  " << error << "\n";
+    }
+    if (result.rejected > result.errors.size()) {
+        out << "  ... " << (result.rejected - result.errors.size()) << " more\n";
+    }
+}
+
+}
+
+int runBatchMode(std::istream& in, std::ostream& out, BatchContext& context) {
+    std::vector<Transfer> pending;
+    int failures = 0;
+    int lineNumber = 0;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command) || command[0] == '#') {
+            continue;
+        }
+
+        try {
+            if (command == "transfer") {
+                std::string fromCode, toCode;
+                double amount;
+                if (!(words >> fromCode >> toCode >> amount)) {
+                    throw std::invalid_argument("Usage: transfer <from-code> <to-code> <amount>");
+                }
+                Transfer transfer;
+                transfer.fromIndex = findAccount(context.index, fromCode);
+                transfer.toIndex = findAccount(context.index, toCode);
+                transfer.amount = amount;
+                pending.push_back(transfer);
+            } else if (command == "commit") {
+                unsigned long long batchId = context.transfers.applyBatch(pending);
+                out << "[OK] Batch " << batchId << " committed: "
+                    << pending.size() << " transfers\n";
+                pending.clear();
+            } else if (command == "abort") {
+                out << "[OK] Discarded " << pending.size() << " pending transfers\n";
+                pending.clear();
+            } else if (command == "balance") {
+                std::string code;
+                if (!(words >> code)) {
+                    throw std::invalid_argument("Usage: balance <code>");
+                }
+                const BankAccount& account = context.accounts[findAccount(context.index, code)];
+                out << account.getUniqueCode() << " " << std::fixed << std::setprecision(2)
+                    << account.getBalance() << " BGN\n";
+            } else if (command == "report") {
+                std::shared_ptr<const BookSnapshot> snapshot = context.snapshots.acquire();
+                out << "Snapshot version " << snapshot->getVersion() << "\n";
+                for (size_t i = 0; i < snapshot->size(); ++i) {
+                    const AccountSnapshot& account = (*snapshot)[i];
+                    out << account.getUniqueCode() << " " << std::fixed << std::setprecision(2)
+                        << account.totalDeposited << " " << account.totalWithdrawn << " "
+                        << account.getBalance() << "\n";
+                }
+            } else if (command == "find-code") {
+                std::string prefix;
+                size_t limit = FIND_LIMIT;
+                if (!(words >> prefix)) {
+                    throw std::invalid_argument("Usage: find-code <prefix> [limit]");
+                }
+                words >> limit;
+                printMatches(context.accounts, context.index.findByCode(prefix, 0, limit), out);
+            } else if (command == "find-owner") {
+                std::string prefix;
+                std::getline(words >> std::ws, prefix);
+                if (prefix.empty()) {
+                    throw std::invalid_argument("Usage: find-owner <prefix>");
+                }
+                printMatches(context.accounts, context.index.findByOwner(prefix, 0, FIND_LIMIT), out);
+            } else if (command == "book-stats") {
+                long long binCount = 10;
+                if (!(words >> std::ws).eof() && !(words >> binCount)) {
+                    binCount = 0;
+                }
+                if (binCount < 1 || binCount > static_cast<long long>(MAX_HISTOGRAM_BINS)) {
+                    throw std::invalid_argument("Usage: book-stats [bins], with 1 to " +
+                                                std::to_string(MAX_HISTOGRAM_BINS) + " bins");
+                }
+                printBookStats(*context.snapshots.acquire(), static_cast<size_t>(binCount), out);
+            } else if (command == "count-above") {
+                double threshold;
+                if (!(words >> threshold)) {
+                    throw std::invalid_argument("Usage: count-above <amount>");
+                }
+                std::vector<double> deposited, withdrawn;
+                context.snapshots.acquire()->collectTotals(deposited, withdrawn);
+                subtractAmounts(deposited.data(), withdrawn.data(), deposited.data(), deposited.size());
+                out << countAtLeast(deposited.data(), deposited.size(), threshold)
+                    << " accounts with balance >= " << std::fixed << std::setprecision(2)
+                    << threshold << "\n";
+            } else if (command == "verify-kernels") {
+                std::string failure;
+                if (!verifyAmountKernels(failure)) {
+                    throw std::runtime_error("Kernel mismatch: " + failure);
+                }
+                out << "[OK] Kernels match the scalar path (using "
+                    << amountKernelsImplementation() << ")\n";
+            } else if (command == "export") {
+                std::string kind, filename;
+                if (!(words >> kind >> filename)) {
+                    throw std::invalid_argument("Usage: export accounts|transactions <file.csv|file.jsonl>");
+                }
+                exportAccounts(context.accounts, filename, exchangeRecordsFor(kind));
+                out << "[OK] Exported " << kind << " to " << filename << "\n";
+            } else if (command == "export-dat") {
+                std::string dataFile, kind, filename;
+                if (!(words >> dataFile >> kind >> filename)) {
+                    throw std::invalid_argument(
+                        "Usage: export-dat <data-file> accounts|transactions <file.csv|file.jsonl>");
+                }
+                exportDataFile(dataFile, filename, exchangeRecordsFor(kind));
+                out << "[OK] Exported " << kind << " from " << dataFile << " to " << filename << "\n";
+            } else if (command == "import") {
+                std::string kind, filename;
+                if (!(words >> kind >> filename)) {
+                    throw std::invalid_argument("Usage: import accounts|transactions <file.csv|file.jsonl>");
+                }
+                ImportResult result = importRecords(filename, exchangeRecordsFor(kind),
+                                                    context.accounts, context.index);
+                context.snapshots.publishAll(context.accounts);
+                printImportResult(result, out);
+                if (result.rejected > 0) {
+                    ++failures;
+                }
+            } else if (command == "save-shards") {
+                size_t shardCount;
+                if (!(words >> shardCount)) {
+                    throw std::invalid_argument("Usage: save-shards <count>");
+                }
+                if (shardCount == 0) {
+                    saveAccountsFile("bank_accounts.dat", context.accounts);
+                    removeShards("bank_accounts.manifest");
+                    out << "[OK] Saved " << context.accounts.size() << " accounts to bank_accounts.dat\n";
+                } else {
+                    ShardReport report = saveShards("bank_accounts.manifest", context.accounts, shardCount);
+                    for (const auto& shard : report.shards) {
+                        if (!shard.error.empty()) {
+                            out << "  " << shard.filename << ": " << shard.error << "\n";
+                        }
+                    }
+                    if (report.failedCount() > 0) {
+                        throw std::runtime_error(std::to_string(report.failedCount()) +
+                                                 " shards were not saved");
+                    }
+                    out << "[OK] " << report.writtenCount() << " of " << shardCount
+                        << " shards written, " << context.accounts.size() << " accounts\n";
+                }
+            } else if (command == "ingest") {
+                std::string feed;
+                if (!(words >> feed)) {
+                    throw std::invalid_argument("Usage: ingest <feed.csv|feed.jsonl>");
+                }
+                IngestReport report = ingestTransactions(feed, context.index, context.transfers);
+                printIngestReport(report, out);
+                if (!report.error.empty()) {
+                    throw std::runtime_error(report.error);
+                }
+                if (report.rejected > 0) {
+                    ++failures;
+                }
+            } else if (command == "anomalies") {
+                double threshold = 3.0;
+                size_t limit = FIND_LIMIT;
+                words >> threshold >> limit;
+                std::shared_ptr<const BookSnapshot> snapshot = context.snapshots.acquire();
+                printAnomalies(*snapshot, findAnomalies(*snapshot, threshold), limit, out);
+            } else if (command == "account-stats") {
+                std::string code;
+                if (!(words >> code)) {
+                    throw std::invalid_argument("Usage: account-stats <code>");
+                }
+                const BankAccount& account = context.accounts[findAccount(context.index, code)];
+                const TransactionStats* series[] = { &account.getDepositStats(), &account.getWithdrawalStats() };
+                const char* names[] = { "deposits", "withdrawals" };
+                for (int i = 0; i < 2; ++i) {
+                    const TransactionStats& stats = *series[i];
+                    out << account.getUniqueCode() << " " << names[i] << ": count " << stats.count
+                        << std::fixed << std::setprecision(2) << ", mean " << stats.mean
+                        << ", stddev " << stats.stddev() << ", min " << stats.min << ", max " << stats.max
+                        << ", last " << stats.last << ", large " << stats.largeCount << "\n";
+                }
+            } else if (command == "memory") {
+                printMemoryReport(measureMemory(context.accounts, context.index,
+                                                *context.snapshots.acquire()), out);
+            } else if (command == "compact") {
+                printCompactionResult(compactAccounts(context.accounts), out);
+            } else {
+                throw std::invalid_argument("Unknown command: " + command);
+            }
+        } catch (const std::exception& e) {
+            out << "[ERROR] Line " << lineNumber << ": " << e.what() << "\n";
+            ++failures;
+            if (command == "commit") {
+                pending.clear();
+            }
+        }
+    }
+
+    if (!pending.empty()) {
+        out << "[ERROR] " << pending.size() << " transfers were never committed\n";
+        ++failures;
+    }
+
+    return failures;
+}
@@ -0,0 +1,335 @@
+#include "Checksum.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BANK_HAVE_SSE42_CRC 1
+#endif
+
+namespace {
+
+const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78u; // Reflected Castagnoli polynomial
+
+// Slicing-by-8 tables for the portable implementation
+struct Crc32cTables {
+    uint32_t table[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                uint32_t previous = table[slice - 1][i];
+                table[slice][i] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32cTables& crcTables() {
+    static const Crc32cTables tables;
+    return tables;
+}
+
+uint32_t crc32cPortable(const unsigned char* data, size_t length, uint32_t crc) {
+    const Crc32cTables& t = crcTables();
+
+    while (length >= 8) {
+        uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+                              static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+        crc = t.table[7][low & 0xFF] ^ t.table[6][(low >> 8) & 0xFF] ^
+              t.table[5][(low >> 16) & 0xFF] ^ t.table[4][low >> 24] ^
+              t.table[3][data[4]] ^ t.table[2][data[5]] ^
+              t.table[1][data[6]] ^ t.table[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ t.table[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef BANK_HAVE_SSE42_CRC
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(const unsigned char* data, size_t length, uint32_t crc) {
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        length -= 8;
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    while (length--) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+    }
+    return crc32;
+}
+#endif
+
+typedef uint32_t (*Crc32cFunction)(const unsigned char*, size_t, uint32_t);
+
+Crc32cFunction selectCrc32c() {
+#ifdef BANK_HAVE_SSE42_CRC
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cHardware;
+    }
+#endif
+    return crc32cPortable;
+}
+
+const Crc32cFunction crc32cImpl = selectCrc32c();
+
+// True when a line of the file starts with "#CRC32C"
+bool findTrailerMarker(std::istream& file, std::vector<char>& block) {
+    static const char MARKER[] = "\n#CRC32C";
+    const size_t markerLength = sizeof(MARKER) - 1;
+    std::string window("\n"); // The first line counts too
+
+    while (file) {
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        window.append(block.data(), static_cast<size_t>(file.gcount()));
+        if (window.find(MARKER) != std::string::npos) {
+            return true;
+        }
+        // Keep enough of the tail to catch a marker split across reads
+        window.erase(0, window.size() > markerLength ? window.size() - markerLength : 0);
+    }
+    return false;
+}
+
+// File CRC: CRC32C over the block CRCs serialized little-endian
+uint32_t combineBlockCrcs(const std::vector<uint32_t>& blockCrcs) {
+    uint32_t crc = 0;
+    for (uint32_t blockCrc : blockCrcs) {
+        unsigned char bytes[4] = {
+            static_cast<unsigned char>(blockCrc), static_cast<unsigned char>(blockCrc >> 8),
+            static_cast<unsigned char>(blockCrc >> 16), static_cast<unsigned char>(blockCrc >> 24)
+        };
+        crc = crc32c(bytes, sizeof(bytes), crc);
+    }
+    return crc;
+}
+
+}
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    return ~crc32cImpl(static_cast<const unsigned char*>(data), length, ~crc);
+}
+
+const char* crc32cImplementation() {
+#ifdef BANK_HAVE_SSE42_CRC
+    if (crc32cImpl == crc32cHardware) {
+        return "sse4.2";
+    }
+#endif
+    return "portable";
+}
+
+ChecksumStreamBuf::ChecksumStreamBuf(std::streambuf* target)
+    : target(target), buffer(CHECKSUM_BLOCK_SIZE), payloadLength(0), finished(false) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+bool ChecksumStreamBuf::writeBlock() {
+    std::streamsize size = pptr() - pbase();
+    if (size == 0) {
+        return true;
+    }
+
+    blockCrcs.push_back(crc32c(pbase(), static_cast<size_t>(size)));
+    payloadLength += static_cast<unsigned long long>(size);
+    bool written = target->sputn(pbase(), size) == size;
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return written;
+}
+
+ChecksumStreamBuf::int_type ChecksumStreamBuf::overflow(int_type ch) {
+    if (finished || !writeBlock()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int ChecksumStreamBuf::sync() {
+    // Partial blocks stay buffered so block boundaries do not depend on flushes
+    return 0;
+}
+
+bool ChecksumStreamBuf::finish() {
+    if (finished) {
+        return true;
+    }
+    bool ok = writeBlock();
+    finished = true;
+
+    std::ostringstream trailer;
+    trailer << "#CRC32C-BLOCKS " << CHECKSUM_BLOCK_SIZE << " " << blockCrcs.size() << "\n";
+    trailer << std::hex << std::setfill('0');
+    for (uint32_t blockCrc : blockCrcs) {
+        trailer << std::setw(8) << blockCrc << "\n";
+    }
+    trailer << std::dec << "#CRC32C " << payloadLength << " "
+            << std::hex << std::setw(8) << combineBlockCrcs(blockCrcs) << "\n";
+
+    const std::string text = trailer.str();
+    ok = ok && target->sputn(text.data(), static_cast<std::streamsize>(text.size())) ==
+                   static_cast<std::streamsize>(text.size());
+    return ok && target->pubsync() == 0;
+}
+
+ChecksumReport::ChecksumReport()
+    : hasChecksums(false), valid(false), payloadLength(0),
+      blockCount(0), badBlocks(0), firstBadBlock(0) {
+}
+
+bool readChecksumTrailer(std::istream& file, unsigned long long fileSize,
+                         ChecksumTrailer& trailer, ChecksumReport& report) {
+    // The footer is the last line of the file
+    const unsigned long long tailSize = fileSize < 128 ? fileSize : 128;
+    std::string tail(static_cast<size_t>(tailSize), '\0');
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(fileSize - tailSize));
+    file.read(&tail[0], static_cast<std::streamsize>(tailSize));
+    if (!file) {
+        report.error = "Cannot read file";
+        return false;
+    }
+
+    size_t footerStart = tail.rfind("#CRC32C");
+    if (footerStart == std::string::npos) {
+        return false; // Legacy file without checksums, or a trailer cut off before its footer
+    }
+    report.hasChecksums = true;
+
+    uint32_t expectedFileCrc = 0;
+    std::istringstream footer(tail.substr(footerStart));
+    std::string magic;
+    footer >> magic >> report.payloadLength >> std::hex >> expectedFileCrc;
+    if (!footer || magic != "#CRC32C" || (footerStart > 0 && tail[footerStart - 1] != '\n') ||
+        !(footer >> std::ws).eof() || report.payloadLength > fileSize) {
+        report.error = "Malformed checksum footer";
+        return false;
+    }
+
+    file.seekg(static_cast<std::streamoff>(report.payloadLength));
+    std::string header;
+    size_t blockSize = 0;
+    if (!(file >> header >> blockSize >> report.blockCount) || header != "#CRC32C-BLOCKS" ||
+        blockSize == 0 || blockSize > (64u << 20) ||
+        report.blockCount != (report.payloadLength + blockSize - 1) / blockSize) {
+        report.error = "Malformed checksum block list";
+        return false;
+    }
+
+    trailer.payloadLength = report.payloadLength;
+    trailer.blockSize = blockSize;
+    trailer.blockCrcs.assign(report.blockCount, 0);
+    file >> std::hex;
+    for (size_t i = 0; i < report.blockCount; ++i) {
+        if (!(file >> trailer.blockCrcs[i])) {
+            report.error = "Truncated checksum block list";
+            return false;
+        }
+    }
+    file >> std::dec;
+    if (combineBlockCrcs(trailer.blockCrcs) != expectedFileCrc) {
+        report.error = "Checksum trailer is corrupted";
+        return false;
+    }
+    return true;
+}
+
+BlockVerifier::BlockVerifier(const ChecksumTrailer& trailer)
+    : trailer(trailer), seen(0), block(0), blockFill(0), crc(0), badBlocks(0), firstBadBlock(0) {
+}
+
+void BlockVerifier::update(const char* data, size_t length) {
+    while (length > 0 && seen < trailer.payloadLength) {
+        size_t take = std::min(length, trailer.blockSize - blockFill);
+        if (trailer.payloadLength - seen < take) {
+            take = static_cast<size_t>(trailer.payloadLength - seen);
+        }
+        crc = crc32c(data, take, crc);
+        data += take;
+        length -= take;
+        seen += take;
+        blockFill += take;
+
+        if (blockFill == trailer.blockSize || seen == trailer.payloadLength) {
+            if (crc != trailer.blockCrcs[block]) {
+                if (badBlocks == 0) {
+                    firstBadBlock = block;
+                }
+                ++badBlocks;
+            }
+            ++block;
+            blockFill = 0;
+            crc = 0;
+        }
+    }
+}
+
+unsigned long long BlockVerifier::remaining() const {
+    return trailer.payloadLength - seen;
+}
+
+void BlockVerifier::finish(ChecksumReport& report) const {
+    // Blocks never seen in full (a short file) count as bad
+    report.badBlocks = badBlocks + (trailer.blockCrcs.size() - block);
+    report.firstBadBlock = badBlocks > 0 ? firstBadBlock : block;
+    report.valid = report.badBlocks == 0;
+}
+
+ChecksumReport verifyChecksums(const std::string& filename) {
+    ChecksumReport report;
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        report.error = "Cannot open file";
+        return report;
+    }
+
+    file.seekg(0, std::ios::end);
+    const unsigned long long fileSize = static_cast<unsigned long long>(file.tellg());
+
+    ChecksumTrailer trailer;
+    const bool haveTrailer = readChecksumTrailer(file, fileSize, trailer, report);
+    file.clear();
+    file.seekg(0);
+
+    std::vector<char> block(CHECKSUM_BLOCK_SIZE);
+    if (!haveTrailer) {
+        // Only a file that never had a trailer counts as legacy; a block list
+        // without its footer means the end of the file was lost
+        if (!report.hasChecksums && report.error.empty() && findTrailerMarker(file, block)) {
+            report.hasChecksums = true;
+            report.error = "Checksum footer is missing or damaged";
+        }
+        return report;
+    }
+
+    BlockVerifier verifier(trailer);
+    while (verifier.remaining() > 0 && file) {
+        size_t size = verifier.remaining() < block.size() ? static_cast<size_t>(verifier.remaining()) : block.size();
+        file.read(block.data(), static_cast<std::streamsize>(size));
+        verifier.update(block.data(), static_cast<size_t>(file.gcount()));
+    }
+    verifier.finish(report);
+    return report;
+}
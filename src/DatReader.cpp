@@ -0,0 +1,357 @@
+#include "DatReader.h"
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <clocale>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
+namespace {
+
+// Powers of ten that a double represents exactly
+const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const unsigned long long MAX_EXACT_MANTISSA = 1ULL << 53;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+void trim(const char*& begin, const char*& end) {
+    while (begin < end && isSpace(*begin)) ++begin;
+    while (end > begin && isSpace(end[-1])) --end;
+}
+
+// strtod in the "C" locale, whatever locale the program has set
+#if defined(_WIN32)
+double strtodC(const char* text, char** stop) {
+    static const _locale_t cLocale = _create_locale(LC_NUMERIC, "C");
+    return _strtod_l(text, stop, cLocale);
+}
+#else
+double strtodC(const char* text, char** stop) {
+    static const locale_t cLocale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+    return strtod_l(text, stop, cLocale);
+}
+#endif
+
+// Full-precision conversion for the rare inputs the fast path cannot handle
+bool parseAmountSlow(const char* begin, const char* end, double& value) {
+    std::string text(begin, end);
+    char* stop = nullptr;
+    value = strtodC(text.c_str(), &stop);
+    return stop == text.c_str() + text.size();
+}
+
+}
+
+bool parseAmount(const char* begin, const char* end, double& value) {
+    trim(begin, end);
+    const char* p = begin;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    unsigned long long mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+
+    while (p < end && isDigit(*p)) {
+        anyDigits = true;
+        if (significantDigits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            if (mantissa != 0) ++significantDigits;
+        } else {
+            ++exponent; // Dropped digit; only the slow path can round it correctly
+            significantDigits = 20;
+        }
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            anyDigits = true;
+            if (significantDigits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                if (mantissa != 0) ++significantDigits;
+                --exponent;
+            } else {
+                significantDigits = 20;
+            }
+            ++p;
+        }
+    }
+    if (!anyDigits) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) {
+            return false;
+        }
+        int written = 0;
+        while (p < end && isDigit(*p)) {
+            if (written < 100000) {
+                written = written * 10 + (*p - '0');
+            }
+            ++p;
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (p != end) {
+        return false;
+    }
+
+    // Clinger's fast path: one exact multiply or divide is correctly rounded
+    if (significantDigits <= 19 && mantissa <= MAX_EXACT_MANTISSA &&
+        exponent >= -22 && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0) {
+            result /= EXACT_POWERS_OF_TEN[-exponent];
+        } else {
+            result *= EXACT_POWERS_OF_TEN[exponent];
+        }
+        value = negative ? -result : result;
+        return true;
+    }
+
+    return parseAmountSlow(begin, end, value);
+}
+
+size_t formatAmount(double value, char* text) {
+    int length = std::snprintf(text, 32, "%.15g", value);
+    double check;
+    if (!parseAmount(text, text + length, check) || check != value) {
+        length = std::snprintf(text, 32, "%.17g", value);
+    }
+    return static_cast<size_t>(length);
+}
+
+bool parseInteger(const char* begin, const char* end, long long& value) {
+    trim(begin, end);
+    const char* p = begin;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+
+    unsigned long long magnitude = 0;
+    for (; p < end; ++p) {
+        if (!isDigit(*p)) {
+            return false;
+        }
+        magnitude = magnitude * 10 + static_cast<unsigned>(*p - '0');
+        if (magnitude > static_cast<unsigned long long>(LLONG_MAX)) {
+            return false;
+        }
+    }
+
+    value = negative ? -static_cast<long long>(magnitude) : static_cast<long long>(magnitude);
+    return true;
+}
+
+DatReader::DatReader(const std::string& filename, size_t blockSize)
+    : file(filename, std::ios::binary), buffer(blockSize), position(0), filled(0),
+      consumed(0), fileSize(0), lineNumber(0), verifying(false) {
+    if (file) {
+        file.seekg(0, std::ios::end);
+        fileSize = static_cast<unsigned long long>(file.tellg());
+        file.seekg(0);
+    }
+}
+
+bool DatReader::isOpen() const {
+    return file.is_open() && !file.bad();
+}
+
+void DatReader::beginVerification() {
+    verifying = true;
+    ChecksumTrailer trailer;
+    if (readChecksumTrailer(file, fileSize, trailer, verification)) {
+        verifier.reset(new BlockVerifier(trailer));
+    }
+    file.clear();
+    file.seekg(0);
+}
+
+ChecksumReport DatReader::finishVerification() {
+    if (verifier) {
+        while (verifier->remaining() > 0) {
+            position = filled; // Skip what the parser left unread
+            if (!refill()) {
+                break;
+            }
+        }
+        verifier->finish(verification);
+    } else if (verifying && !verification.hasChecksums) {
+        do {
+            for (; position < filled; ++position) {
+                if (!isSpace(buffer[position])) {
+                    verification.hasChecksums = true;
+                    verification.error = "Unexpected data after the last account (damaged checksum trailer)";
+                    return verification;
+                }
+            }
+        } while (refill());
+    }
+    return verification;
+}
+
+bool DatReader::refill() {
+    // Move the unfinished line to the front, growing the buffer if a single line fills it
+    size_t leftover = filled - position;
+    if (leftover > 0 && position > 0) {
+        std::memmove(buffer.data(), buffer.data() + position, leftover);
+    }
+    consumed += position;
+    position = 0;
+    filled = leftover;
+    if (filled == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    file.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+    std::streamsize got = file.gcount();
+    if (verifier) {
+        verifier->update(buffer.data() + filled, static_cast<size_t>(got));
+    }
+    filled += static_cast<size_t>(got);
+    return got > 0;
+}
+
+void DatReader::fail(const char* what) const {
+    std::ostringstream message;
+    message << "Line " << lineNumber << ": " << what;
+    throw std::runtime_error(message.str());
+}
+
+bool DatReader::nextLine(const char*& text, size_t& length) {
+    size_t scanFrom = position;
+    while (true) {
+        const char* start = buffer.data() + position;
+        const char* newline = static_cast<const char*>(
+            std::memchr(buffer.data() + scanFrom, '\n', filled - scanFrom));
+        if (newline) {
+            text = start;
+            length = static_cast<size_t>(newline - start);
+            position = static_cast<size_t>(newline - buffer.data()) + 1;
+            ++lineNumber;
+            return true;
+        }
+
+        size_t scanned = filled - position;
+        if (!refill()) {
+            // Last line without a terminator
+            if (filled == position) {
+                return false;
+            }
+            text = buffer.data() + position;
+            length = filled - position;
+            position = filled;
+            ++lineNumber;
+            return true;
+        }
+        scanFrom = position + scanned;
+    }
+}
+
+void DatReader::nextCode(const char*& text, size_t& length) {
+    if (!nextLine(text, length)) {
+        fail("unexpected end of file");
+    }
+    const char* end = text + length;
+    while (text < end && isSpace(*text)) ++text;
+    const char* tokenEnd = text;
+    while (tokenEnd < end && !isSpace(*tokenEnd)) ++tokenEnd;
+    length = static_cast<size_t>(tokenEnd - text);
+}
+
+void DatReader::nextOwnerName(const char*& text, size_t& length) {
+    if (!nextLine(text, length)) {
+        fail("unexpected end of file");
+    }
+    if (length > 0 && text[length - 1] == '\r') {
+        --length;
+    }
+}
+
+unsigned long long DatReader::nextAccountCount() {
+    const char* text;
+    size_t length;
+    long long value;
+    if (!nextLine(text, length) || !parseInteger(text, text + length, value) || value < 0) {
+        fail("bad account count");
+    }
+    return static_cast<unsigned long long>(value);
+}
+
+int DatReader::nextTransactionCount() {
+    const char* text;
+    size_t length;
+    long long value;
+    if (!nextLine(text, length) || !parseInteger(text, text + length, value) ||
+        value < 0 || value > INT_MAX) {
+        fail("bad transaction count");
+    }
+    // Every amount takes at least two bytes, so larger counts cannot be genuine
+    if (static_cast<unsigned long long>(value) > bytesRemaining() / 2) {
+        fail("transaction count exceeds the file size");
+    }
+    return static_cast<int>(value);
+}
+
+double DatReader::nextAmount() {
+    const char* text;
+    size_t length;
+    double value;
+    if (!nextLine(text, length) || !parseAmount(text, text + length, value)) {
+        fail("bad amount");
+    }
+    return value;
+}
+
+bool DatReader::nextStats(TransactionStats& deposits, TransactionStats& withdrawals) {
+    if (position == filled && !refill()) {
+        return false;
+    }
+    if (buffer[position] != '@') {
+        return false;
+    }
+    const char* text;
+    size_t length;
+    nextLine(text, length);
+    return parseStatsLine(text, length, deposits, withdrawals);
+}
+
+unsigned long long DatReader::bytesRead() const {
+    return consumed + position;
+}
+
+unsigned long long DatReader::bytesRemaining() const {
+    return fileSize > bytesRead() ? fileSize - bytesRead() : 0;
+}
@@ -0,0 +1,836 @@
+#include "DataExchange.h"
+#include "DatReader.h"
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <unordered_set>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+const size_t MAX_REPORTED_ERRORS = 10;
+
+// ---------------------------------------------------------------- output
+
+class OutputBuffer {
+private:
+    std::ofstream file;
+    std::vector<char> buffer;
+    size_t used;
+
+public:
+    explicit OutputBuffer(const std::string& filename)
+        : file(filename, std::ios::binary), buffer(OUTPUT_BUFFER_SIZE), used(0) {
+        if (!file) {
+            throw std::runtime_error("Cannot create " + filename);
+        }
+    }
+
+    void flush() {
+        file.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+        if (!file) {
+            throw std::runtime_error("Cannot write export file");
+        }
+    }
+
+    void write(const char* text, size_t length) {
+        if (used + length > buffer.size()) {
+            flush();
+            if (length > buffer.size()) {
+                file.write(text, static_cast<std::streamsize>(length));
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, text, length);
+        used += length;
+    }
+
+    void write(const std::string& text) {
+        write(text.data(), text.size());
+    }
+
+    void put(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void amount(double value) {
+        char text[32];
+        write(text, formatAmount(value, text));
+    }
+
+    void csvField(const char* text, size_t length) {
+        if (std::memchr(text, ',', length) == nullptr && std::memchr(text, '"', length) == nullptr &&
+            std::memchr(text, '\r', length) == nullptr) {
+            write(text, length);
+            return;
+        }
+        put('"');
+        for (size_t i = 0; i < length; ++i) {
+            if (text[i] == '"') {
+                put('"');
+            }
+            put(text[i]);
+        }
+        put('"');
+    }
+
+    void jsonString(const char* text, size_t length) {
+        put('"');
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(static_cast<char>(c));
+            } else if (c < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                write(escape, 6);
+            } else {
+                put(static_cast<char>(c));
+            }
+        }
+        put('"');
+    }
+
+    void close() {
+        flush();
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Cannot write export file");
+        }
+    }
+};
+
+// Receives one account at a time, amounts streamed in file order
+class RecordWriter {
+public:
+    virtual ~RecordWriter() {}
+    virtual void beginAccount(const char* code, size_t codeLength,
+                              const char* owner, size_t ownerLength) = 0;
+    virtual void beginDeposits(int count) = 0;
+    virtual void beginWithdrawals(int count) = 0;
+    virtual void amount(double value) = 0;
+    virtual void endAccount() = 0;
+};
+
+class CsvAccountsWriter : public RecordWriter {
+private:
+    OutputBuffer& out;
+    std::string code, owner;
+    int depositCount, withdrawalCount;
+    double totalDeposited, totalWithdrawn;
+    bool inWithdrawals;
+
+public:
+    explicit CsvAccountsWriter(OutputBuffer& out)
+        : out(out), depositCount(0), withdrawalCount(0),
+          totalDeposited(0.0), totalWithdrawn(0.0), inWithdrawals(false) {
+        out.write("code,owner,deposits,withdrawals,total_deposited,total_withdrawn,balance\n");
+    }
+
+    void beginAccount(const char* codeText, size_t codeLength,
+                      const char* ownerText, size_t ownerLength) override {
+        code.assign(codeText, codeLength);
+        owner.assign(ownerText, ownerLength);
+        totalDeposited = totalWithdrawn = 0.0;
+        inWithdrawals = false;
+    }
+
+    void beginDeposits(int count) override { depositCount = count; }
+
+    void beginWithdrawals(int count) override {
+        withdrawalCount = count;
+        inWithdrawals = true;
+    }
+
+    void amount(double value) override {
+        (inWithdrawals ? totalWithdrawn : totalDeposited) += value;
+    }
+
+    void endAccount() override {
+        char counts[32];
+        out.csvField(code.data(), code.size());
+        out.put(',');
+        out.csvField(owner.data(), owner.size());
+        out.write(counts, static_cast<size_t>(
+            std::snprintf(counts, sizeof(counts), ",%d,%d,", depositCount, withdrawalCount)));
+        out.amount(totalDeposited);
+        out.put(',');
+        out.amount(totalWithdrawn);
+        out.put(',');
+        out.amount(totalDeposited - totalWithdrawn);
+        out.put('\n');
+    }
+};
+
+class CsvTransactionsWriter : public RecordWriter {
+private:
+    OutputBuffer& out;
+    std::string code;
+    const char* type;
+
+public:
+    explicit CsvTransactionsWriter(OutputBuffer& out) : out(out), type("deposit") {
+        out.write("code,type,amount\n");
+    }
+
+    void beginAccount(const char* codeText, size_t codeLength, const char*, size_t) override {
+        code.assign(codeText, codeLength);
+    }
+
+    void beginDeposits(int) override { type = "deposit,"; }
+    void beginWithdrawals(int) override { type = "withdrawal,"; }
+
+    void amount(double value) override {
+        out.csvField(code.data(), code.size());
+        out.put(',');
+        out.write(type, std::strlen(type));
+        out.amount(value);
+        out.put('\n');
+    }
+
+    void endAccount() override {}
+};
+
+class JsonAccountsWriter : public RecordWriter {
+private:
+    OutputBuffer& out;
+    bool firstAmount;
+
+public:
+    explicit JsonAccountsWriter(OutputBuffer& out) : out(out), firstAmount(true) {}
+
+    void beginAccount(const char* code, size_t codeLength,
+                      const char* owner, size_t ownerLength) override {
+        out.write("{\"code\":");
+        out.jsonString(code, codeLength);
+        out.write(",\"owner\":");
+        out.jsonString(owner, ownerLength);
+    }
+
+    void beginDeposits(int) override {
+        out.write(",\"deposits\":[");
+        firstAmount = true;
+    }
+
+    void beginWithdrawals(int) override {
+        out.write("],\"withdrawals\":[");
+        firstAmount = true;
+    }
+
+    void amount(double value) override {
+        if (!firstAmount) {
+            out.put(',');
+        }
+        firstAmount = false;
+        out.amount(value);
+    }
+
+    void endAccount() override {
+        out.write("]}\n");
+    }
+};
+
+class JsonTransactionsWriter : public RecordWriter {
+private:
+    OutputBuffer& out;
+    std::string prefix;     // {"code":"...","type":"
+    const char* type;
+
+public:
+    explicit JsonTransactionsWriter(OutputBuffer& out) : out(out), type("deposit") {}
+
+    void beginAccount(const char* code, size_t codeLength, const char*, size_t) override {
+        prefix.assign("{\"code\":\"");
+        for (size_t i = 0; i < codeLength; ++i) {
+            if (code[i] == '"' || code[i] == '\\') prefix.push_back('\\');
+            prefix.push_back(code[i]);
+        }
+        prefix.append("\",\"type\":\"");
+    }
+
+    void beginDeposits(int) override { type = "deposit\",\"amount\":"; }
+    void beginWithdrawals(int) override { type = "withdrawal\",\"amount\":"; }
+
+    void amount(double value) override {
+        out.write(prefix);
+        out.write(type, std::strlen(type));
+        out.amount(value);
+        out.write("}\n");
+    }
+
+    void endAccount() override {}
+};
+
+std::unique_ptr<RecordWriter> makeWriter(OutputBuffer& out, ExchangeFormat format, ExchangeRecords records) {
+    if (format == ExchangeFormat::Csv) {
+        if (records == ExchangeRecords::Accounts) {
+            return std::unique_ptr<RecordWriter>(new CsvAccountsWriter(out));
+        }
+        return std::unique_ptr<RecordWriter>(new CsvTransactionsWriter(out));
+    }
+    if (records == ExchangeRecords::Accounts) {
+        return std::unique_ptr<RecordWriter>(new JsonAccountsWriter(out));
+    }
+    return std::unique_ptr<RecordWriter>(new JsonTransactionsWriter(out));
+}
+
+// ---------------------------------------------------------------- input
+
+// One parsed row; buffers are reused so memory is bounded by the largest row
+struct ImportRecord {
+    std::string code;
+    std::string owner;
+    std::string type;
+    double amount;
+    bool hasAmount;
+    std::vector<double> deposits;
+    std::vector<double> withdrawals;
+
+    void clear() {
+        code.clear();
+        owner.clear();
+        type.clear();
+        amount = 0.0;
+        hasAmount = false;
+        deposits.clear();
+        withdrawals.clear();
+    }
+};
+
+// Splits one CSV line into fields, honouring "quoted, fields" with "" escapes
+void splitCsv(const char* p, const char* end, std::vector<std::string>& fields) {
+    fields.clear();
+    while (true) {
+        fields.push_back(std::string());
+        std::string& field = fields.back();
+        if (p < end && *p == '"') {
+            ++p;
+            while (p < end) {
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') {
+                        field.push_back('"');
+                        p += 2;
+                        continue;
+                    }
+                    ++p;
+                    break;
+                }
+                field.push_back(*p++);
+            }
+            while (p < end && *p != ',') ++p; // Anything between the closing quote and the comma
+        } else {
+            const char* comma = static_cast<const char*>(std::memchr(p, ',', static_cast<size_t>(end - p)));
+            const char* fieldEnd = comma ? comma : end;
+            field.assign(p, fieldEnd);
+            p = fieldEnd;
+        }
+        if (p >= end) {
+            break;
+        }
+        ++p; // Comma
+    }
+    if (!fields.empty() && !fields.back().empty() && fields.back()[fields.back().size() - 1] == '\r') {
+        fields.back().erase(fields.back().size() - 1);
+    }
+}
+
+void parseCsvRecord(const std::vector<std::string>& fields, ExchangeRecords records, ImportRecord& record) {
+    if (records == ExchangeRecords::Accounts) {
+        if (fields.size() < 2) {
+            throw std::invalid_argument("expected code,owner");
+        }
+        record.code = fields[0];
+        record.owner = fields[1];
+        return;
+    }
+    if (fields.size() < 3) {
+        throw std::invalid_argument("expected code,type,amount");
+    }
+    record.code = fields[0];
+    record.type = fields[1];
+    if (!parseAmount(fields[2].data(), fields[2].data() + fields[2].size(), record.amount) ||
+        !std::isfinite(record.amount)) {
+        throw std::invalid_argument("bad amount \"" + fields[2] + "\"");
+    }
+    record.hasAmount = true;
+}
+
+// Minimal JSON reader for the flat objects used by the JSON Lines formats
+class JsonLine {
+private:
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            throw std::invalid_argument(std::string("expected '") + c + "'");
+        }
+    }
+
+    static void appendUtf8(std::string& out, unsigned long codePoint) {
+        if (codePoint < 0x80) {
+            out.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    unsigned long hex4() {
+        if (end - p < 4) {
+            throw std::invalid_argument("bad \\u escape");
+        }
+        unsigned long value = 0;
+        for (int i = 0; i < 4; ++i, ++p) {
+            char c = *p;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<unsigned long>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned long>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<unsigned long>(c - 'A' + 10);
+            else throw std::invalid_argument("bad \\u escape");
+        }
+        return value;
+    }
+
+public:
+    JsonLine(const char* begin, const char* end) : p(begin), end(end) {}
+
+    void string(std::string& out) {
+        expect('"');
+        out.clear();
+        while (true) {
+            if (p >= end) {
+                throw std::invalid_argument("unterminated string");
+            }
+            char c = *p++;
+            if (c == '"') {
+                return;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (p >= end) {
+                throw std::invalid_argument("unterminated string");
+            }
+            switch (*p++) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    unsigned long codePoint = hex4();
+                    if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                        throw std::invalid_argument("unpaired surrogate in \\u escape");
+                    }
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                        // A high surrogate must be followed by an escaped low one
+                        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+                            throw std::invalid_argument("unpaired surrogate in \\u escape");
+                        }
+                        p += 2;
+                        unsigned long low = hex4();
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            throw std::invalid_argument("unpaired surrogate in \\u escape");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    throw std::invalid_argument("bad escape");
+            }
+        }
+    }
+
+    double number() {
+        skipSpace();
+        const char* start = p;
+        while (p < end && (std::strchr("+-.eE", *p) != nullptr || (*p >= '0' && *p <= '9'))) ++p;
+        double value;
+        if (start == p || !parseAmount(start, p, value) || !std::isfinite(value)) {
+            throw std::invalid_argument("bad number");
+        }
+        return value;
+    }
+
+    void numberArray(std::vector<double>& out) {
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            out.push_back(number());
+        } while (consume(','));
+        expect(']');
+    }
+
+    // Skips a value of a key we do not know (strings, numbers, literals, flat arrays)
+    void skipValue() {
+        skipSpace();
+        if (p < end && *p == '"') {
+            std::string ignored;
+            string(ignored);
+        } else if (p < end && *p == '[') {
+            ++p;
+            int depth = 1;
+            bool inString = false;
+            for (; p < end && depth > 0; ++p) {
+                if (inString) {
+                    if (*p == '\\') ++p;
+                    else if (*p == '"') inString = false;
+                } else if (*p == '"') {
+                    inString = true;
+                } else if (*p == '[') {
+                    ++depth;
+                } else if (*p == ']') {
+                    --depth;
+                }
+            }
+        } else {
+            while (p < end && *p != ',' && *p != '}') ++p;
+        }
+    }
+
+    void object(ImportRecord& record) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        std::string key;
+        do {
+            string(key);
+            expect(':');
+            if (key == "code") string(record.code);
+            else if (key == "owner") string(record.owner);
+            else if (key == "type") string(record.type);
+            else if (key == "amount") { record.amount = number(); record.hasAmount = true; }
+            else if (key == "deposits") numberArray(record.deposits);
+            else if (key == "withdrawals") numberArray(record.withdrawals);
+            else skipValue();
+        } while (consume(','));
+        expect('}');
+        skipSpace();
+        if (p != end) {
+            throw std::invalid_argument("unexpected text after object");
+        }
+    }
+};
+
+// Codes compare case-insensitively, as in AccountIndex
+std::string foldCode(const std::string& code) {
+    std::string key(code);
+    for (char& c : key) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return key;
+}
+
+// Appends the account without touching the index; `imported` holds the folded
+// codes added so far, so duplicates within the file are caught as well
+void applyAccount(const ImportRecord& record, std::vector<BankAccount>& accounts,
+                  const AccountIndex& index, std::unordered_set<std::string>& imported) {
+    size_t position;
+    std::string key = foldCode(record.code);
+    if (index.findCode(record.code, position) || imported.count(key) != 0) {
+        throw std::invalid_argument("account " + record.code + " already exists");
+    }
+    // Fully built and validated before it joins the book
+    BankAccount account(record.code.c_str(), record.owner.c_str());
+    account.reserveTransactions(static_cast<int>(record.deposits.size()),
+                                static_cast<int>(record.withdrawals.size()));
+    for (double amount : record.deposits) {
+        account.addDeposit(amount);
+    }
+    for (double amount : record.withdrawals) {
+        account.addWithdrawal(amount);
+    }
+    accounts.push_back(std::move(account));
+    imported.insert(std::move(key));
+}
+
+void applyTransaction(const TransactionRow& row, std::vector<BankAccount>& accounts,
+                      const AccountIndex& index) {
+    size_t position;
+    if (!index.findCode(row.code, position)) {
+        throw std::invalid_argument("unknown account " + row.code);
+    }
+    if (row.deposit) {
+        accounts[position].addDeposit(row.amount);
+    } else {
+        accounts[position].addWithdrawal(row.amount);
+    }
+}
+
+}
+
+ImportResult::ImportResult() : imported(0), rejected(0) {
+}
+
+TransactionRowParser::TransactionRowParser(ExchangeFormat format) : format(format) {
+}
+
+bool TransactionRowParser::parse(const char* text, size_t length, bool firstLine, TransactionRow& row) {
+    const char* end = text + length;
+    if (length == 0 || (length == 1 && *text == '\r')) {
+        return false;
+    }
+
+    // Unquoted CSV rows, by far the common case, are parsed in place
+    if (format == ExchangeFormat::Csv && std::memchr(text, '"', length) == nullptr && !firstLine) {
+        const char* typeStart = static_cast<const char*>(std::memchr(text, ',', length));
+        const char* amountStart = typeStart ? static_cast<const char*>(
+            std::memchr(typeStart + 1, ',', static_cast<size_t>(end - typeStart - 1))) : nullptr;
+        if (amountStart) {
+            const size_t typeLength = static_cast<size_t>(amountStart - typeStart - 1);
+            const char* amountEnd = static_cast<const char*>(
+                std::memchr(amountStart + 1, ',', static_cast<size_t>(end - amountStart - 1)));
+            if (!amountEnd) amountEnd = end;
+            if ((typeLength == 7 && std::memcmp(typeStart + 1, "deposit", 7) == 0) ||
+                (typeLength == 1 && typeStart[1] == 'D')) {
+                row.deposit = true;
+            } else if ((typeLength == 10 && std::memcmp(typeStart + 1, "withdrawal", 10) == 0) ||
+                       (typeLength == 1 && typeStart[1] == 'W')) {
+                row.deposit = false;
+            } else {
+                throw std::invalid_argument("unknown transaction type \"" +
+                                            std::string(typeStart + 1, typeLength) + "\"");
+            }
+            if (!parseAmount(amountStart + 1, amountEnd, row.amount) || !std::isfinite(row.amount)) {
+                throw std::invalid_argument("bad amount \"" + std::string(amountStart + 1, amountEnd) + "\"");
+            }
+            row.code.assign(text, typeStart);
+            return true;
+        }
+    }
+
+    ImportRecord record;
+    record.clear();
+    if (format == ExchangeFormat::Csv) {
+        splitCsv(text, end, fields);
+        if (firstLine && fields[0] == "code") {
+            return false; // Header
+        }
+        parseCsvRecord(fields, ExchangeRecords::Transactions, record);
+    } else {
+        JsonLine(text, end).object(record);
+    }
+
+    if (!record.hasAmount) {
+        throw std::invalid_argument("missing amount");
+    }
+    if (record.type == "deposit" || record.type == "D") {
+        row.deposit = true;
+    } else if (record.type == "withdrawal" || record.type == "W") {
+        row.deposit = false;
+    } else {
+        throw std::invalid_argument("unknown transaction type \"" + record.type + "\"");
+    }
+    row.code.swap(record.code);
+    row.amount = record.amount;
+    return true;
+}
+
+ExchangeFormat exchangeFormatFor(const std::string& filename) {
+    size_t dot = filename.rfind('.');
+    std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+    if (extension == "csv") {
+        return ExchangeFormat::Csv;
+    }
+    if (extension == "jsonl" || extension == "ndjson") {
+        return ExchangeFormat::JsonLines;
+    }
+    throw std::invalid_argument("Unknown format for \"" + filename + "\" (use .csv or .jsonl)");
+}
+
+ExchangeRecords exchangeRecordsFor(const std::string& kind) {
+    if (kind == "accounts") {
+        return ExchangeRecords::Accounts;
+    }
+    if (kind == "transactions") {
+        return ExchangeRecords::Transactions;
+    }
+    throw std::invalid_argument("Expected \"accounts\" or \"transactions\", got \"" + kind + "\"");
+}
+
+void exportAccounts(const std::vector<BankAccount>& accounts, const std::string& filename,
+                    ExchangeRecords records) {
+    OutputBuffer out(filename);
+    std::unique_ptr<RecordWriter> writer = makeWriter(out, exchangeFormatFor(filename), records);
+
+    for (const auto& account : accounts) {
+        const char* code = account.getUniqueCode();
+        const char* owner = account.getOwnerName();
+        writer->beginAccount(code, std::strlen(code), owner, std::strlen(owner));
+        writer->beginDeposits(account.getDepositedCount());
+        for (int i = 0; i < account.getDepositedCount(); ++i) {
+            writer->amount(account.getDepositedAmount(i));
+        }
+        writer->beginWithdrawals(account.getWithdrawnCount());
+        for (int i = 0; i < account.getWithdrawnCount(); ++i) {
+            writer->amount(account.getWithdrawnAmount(i));
+        }
+        writer->endAccount();
+    }
+    out.close();
+}
+
+void exportDataFile(const std::string& dataFile, const std::string& filename,
+                    ExchangeRecords records) {
+    DatReader reader(dataFile);
+    if (!reader.isOpen()) {
+        throw std::runtime_error("Cannot open " + dataFile);
+    }
+
+    // Checked before the output is created, so a damaged book is never exported as valid data
+    ChecksumReport verification = verifyChecksums(dataFile);
+    if (verification.hasChecksums && !verification.valid) {
+        std::ostringstream message;
+        message << "File \"" << dataFile << "\" is corrupted: ";
+        if (!verification.error.empty()) {
+            message << verification.error;
+        } else {
+            message << verification.badBlocks << " bad block(s), first is block "
+                    << verification.firstBadBlock;
+        }
+        throw std::runtime_error(message.str());
+    }
+    OutputBuffer out(filename);
+    std::unique_ptr<RecordWriter> writer = makeWriter(out, exchangeFormatFor(filename), records);
+
+    // The code is copied because reading the owner line may move the reader's buffer
+    std::string code;
+    TransactionStats skippedStats;
+    unsigned long long accountCount = reader.nextAccountCount();
+    for (unsigned long long i = 0; i < accountCount; ++i) {
+        const char* text;
+        size_t length;
+        reader.nextCode(text, length);
+        code.assign(text, length);
+        reader.nextOwnerName(text, length);
+        writer->beginAccount(code.data(), code.size(), text, length);
+
+        int count = reader.nextTransactionCount();
+        writer->beginDeposits(count);
+        for (int j = 0; j < count; ++j) {
+            writer->amount(reader.nextAmount());
+        }
+        count = reader.nextTransactionCount();
+        writer->beginWithdrawals(count);
+        for (int j = 0; j < count; ++j) {
+            writer->amount(reader.nextAmount());
+        }
+        reader.nextStats(skippedStats, skippedStats);
+        writer->endAccount();
+    }
+    out.close();
+}
+
+ImportResult importRecords(const std::string& filename, ExchangeRecords records,
+                           std::vector<BankAccount>& accounts, AccountIndex& index) {
+    const ExchangeFormat format = exchangeFormatFor(filename);
+    DatReader reader(filename);
+    if (!reader.isOpen()) {
+        throw std::runtime_error("Cannot open " + filename);
+    }
+
+    ImportResult result;
+    ImportRecord record;
+    TransactionRow row;
+    TransactionRowParser rowParser(format);
+    std::vector<std::string> fields;
+    std::unordered_set<std::string> importedCodes;
+    const char* text;
+    size_t length;
+    unsigned long long lineNumber = 0;
+
+    // New accounts are only appended below; the index is rebuilt once at the
+    // end instead of paying a sorted insert per row
+    const size_t accountsBefore = accounts.size();
+    try {
+        while (reader.nextLine(text, length)) {
+            ++lineNumber;
+            const char* end = text + length;
+            if (length == 0 || (length == 1 && *text == '\r')) {
+                continue;
+            }
+
+            try {
+                if (records == ExchangeRecords::Transactions) {
+                    if (rowParser.parse(text, length, lineNumber == 1, row)) {
+                        applyTransaction(row, accounts, index);
+                        ++result.imported;
+                    }
+                    continue;
+                }
+
+                record.clear();
+                if (format == ExchangeFormat::Csv) {
+                    splitCsv(text, end, fields);
+                    if (lineNumber == 1 && fields[0] == "code") {
+                        continue; // Header
+                    }
+                    parseCsvRecord(fields, records, record);
+                } else {
+                    JsonLine(text, end).object(record);
+                }
+                applyAccount(record, accounts, index, importedCodes);
+                ++result.imported;
+            } catch (const std::exception& e) {
+                ++result.rejected;
+                if (result.errors.size() < MAX_REPORTED_ERRORS) {
+                    std::ostringstream message;
+                    message << "Line " << lineNumber << ": " << e.what();
+                    result.errors.push_back(message.str());
+                }
+            }
+        }
+    } catch (...) {
+        if (accounts.size() != accountsBefore) {
+            index.rebuild(accounts);
+        }
+        throw;
+    }
+    if (accounts.size() != accountsBefore) {
+        index.rebuild(accounts);
+    }
+    return result;
+}
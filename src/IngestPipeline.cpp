@@ -0,0 +1,387 @@
+#include "IngestPipeline.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <exception>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include "DataExchange.h"
+#include "SpscQueue.h"
+
+namespace {
+
+const size_t INGEST_CHUNK_SIZE = 256 * 1024;
+const size_t INGEST_QUEUE_CAPACITY = 16;
+const size_t MAX_REPORTED_ERRORS = 10;
+const size_t MAX_APPLY_GROUP = 8;          // Chunks already waiting are applied together
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct FeedRecord {
+    unsigned long long line;
+    size_t offset;           // Row text within FeedBatch::text
+    size_t length;
+    TransactionRow row;
+    size_t account;
+    std::string error;       // Empty while the row is still good
+};
+
+// One chunk of whole lines; the rows refer into its text until it is applied
+struct FeedBatch {
+    std::string text;
+    unsigned long long firstLine;
+    std::vector<FeedRecord> records;
+};
+
+typedef std::unique_ptr<FeedBatch> BatchPtr;  // nullptr marks the end of the feed
+typedef SpscQueue<BatchPtr> BatchQueue;
+
+void readStage(std::ifstream& file, BatchQueue& out, StageStats& stats, std::string& error) {
+    std::string carry;
+    unsigned long long nextLine = 1;
+    while (true) {
+        Clock::time_point start = Clock::now();
+        BatchPtr batch(new FeedBatch());
+        batch->text.swap(carry);
+
+        // Read until the chunk holds at least one whole line or the file ends
+        size_t lastNewline = std::string::npos;
+        bool atEnd = false;
+        while (lastNewline == std::string::npos && !atEnd) {
+            size_t old = batch->text.size();
+            batch->text.resize(old + INGEST_CHUNK_SIZE);
+            file.read(&batch->text[old], static_cast<std::streamsize>(INGEST_CHUNK_SIZE));
+            size_t got = static_cast<size_t>(file.gcount());
+            batch->text.resize(old + got);
+            stats.items += got;
+            atEnd = got == 0;
+            lastNewline = batch->text.rfind('\n');
+        }
+        if (file.bad()) {
+            error = "Cannot read the feed";
+            stats.busySeconds += secondsSince(start);
+            break;
+        }
+        if (!atEnd) {
+            carry.assign(batch->text, lastNewline + 1, std::string::npos);
+            batch->text.resize(lastNewline + 1);
+        }
+
+        batch->firstLine = nextLine;
+        nextLine += static_cast<unsigned long long>(
+            std::count(batch->text.begin(), batch->text.end(), '\n'));
+        stats.busySeconds += secondsSince(start);
+
+        if (batch->text.empty()) {
+            break;
+        }
+        if (!out.push(std::move(batch)) || atEnd) {
+            break; // Closed after another stage failed, or the end of the feed
+        }
+    }
+    out.push(BatchPtr());
+}
+
+void parseStage(ExchangeFormat format, BatchQueue& in, BatchQueue& out, StageStats& stats) {
+    TransactionRowParser parser(format);
+    while (BatchPtr batch = in.pop()) {
+        Clock::time_point start = Clock::now();
+        const char* text = batch->text.data();
+        const char* end = text + batch->text.size();
+        unsigned long long line = batch->firstLine;
+
+        for (const char* p = text; p < end; ++line) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* lineEnd = newline ? newline : end;
+            size_t length = static_cast<size_t>(lineEnd - p);
+
+            FeedRecord record;
+            record.line = line;
+            record.offset = static_cast<size_t>(p - text);
+            record.length = length;
+            record.account = 0;
+            try {
+                if (parser.parse(p, length, line == 1, record.row)) {
+                    batch->records.push_back(std::move(record));
+                }
+            } catch (const std::exception& e) {
+                record.error = e.what();
+                batch->records.push_back(std::move(record));
+            }
+            p = lineEnd + 1;
+        }
+
+        stats.items += batch->records.size();
+        stats.busySeconds += secondsSince(start);
+        out.push(std::move(batch));
+    }
+    out.push(BatchPtr());
+}
+
+void validateStage(const AccountIndex& index, BatchQueue& in, BatchQueue& out, StageStats& stats) {
+    while (BatchPtr batch = in.pop()) {
+        Clock::time_point start = Clock::now();
+        for (auto& record : batch->records) {
+            if (!record.error.empty()) {
+                continue;
+            }
+            if (record.row.amount < 0) {
+                record.error = record.row.deposit ? "Deposit amount cannot be negative"
+                                                  : "Withdrawal amount cannot be negative";
+            } else if (!index.findCode(record.row.code, record.account)) {
+                record.error = "unknown account " + record.row.code;
+            }
+        }
+        stats.items += batch->records.size();
+        stats.busySeconds += secondsSince(start);
+        out.push(std::move(batch));
+    }
+    out.push(BatchPtr());
+}
+
+void writeRejected(const FeedBatch& batch, const std::string& rejectedPath,
+                   std::ofstream& rejected, IngestReport& report) {
+    for (const auto& record : batch.records) {
+        if (record.error.empty()) {
+            continue;
+        }
+
+        ++report.rejected;
+        if (report.errors.size() < MAX_REPORTED_ERRORS) {
+            std::ostringstream message;
+            message << "Line " << record.line << ": " << record.error;
+            report.errors.push_back(message.str());
+        }
+        if (report.rejected == 1) {
+            rejected.open(rejectedPath, std::ios::binary);
+            if (rejected.is_open()) {
+                report.rejectedFile = rejectedPath;
+            } else if (report.error.empty()) {
+                report.error = "Cannot create " + rejectedPath; // Stops applying further rows
+            }
+        }
+        if (!rejected.is_open()) {
+            continue;
+        }
+        std::string row(batch.text, record.offset, record.length);
+        if (!row.empty() && row[row.size() - 1] == '\r') {
+            row.erase(row.size() - 1);
+        }
+        rejected << record.line << '\t' << record.error << '\t' << row << '\n';
+    }
+}
+
+void applyStage(TransferEngine& transfers, const std::string& rejectedPath, BatchQueue& in,
+                IngestReport& report, StageStats& stats) {
+    std::ofstream rejected;
+    std::vector<Posting> postings;
+    std::vector<BatchPtr> group;
+    bool done = false;
+
+    while (!done) {
+        group.clear();
+        BatchPtr batch = in.pop();
+        while (true) {
+            if (!batch) {
+                done = true; // End marker
+                break;
+            }
+            group.push_back(std::move(batch));
+            if (group.size() == MAX_APPLY_GROUP || !in.tryPop(batch)) {
+                break;
+            }
+        }
+        if (group.empty()) {
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        postings.clear();
+        for (const auto& member : group) {
+            for (const auto& record : member->records) {
+                if (record.error.empty()) {
+                    Posting posting;
+                    posting.accountIndex = record.account;
+                    posting.deposit = record.row.deposit;
+                    posting.amount = record.row.amount;
+                    postings.push_back(posting);
+                }
+            }
+            writeRejected(*member, rejectedPath, rejected, report);
+            stats.items += member->records.size();
+        }
+
+        if (report.error.empty()) {
+            try {
+                transfers.applyPostings(postings);
+                report.applied += postings.size();
+            } catch (const std::exception& e) {
+                // Keep draining so the upstream stages can finish
+                report.error = e.what();
+            }
+        }
+        stats.busySeconds += secondsSince(start);
+    }
+
+    if (report.rejected > 0 && !rejected.flush() && report.error.empty()) {
+        report.error = "Cannot write " + rejectedPath;
+    }
+}
+
+// First exception thrown by any stage. Recording it closes every queue, so
+// stages blocked on one another stop instead of waiting forever.
+class StageFailure {
+private:
+    std::mutex mutex;
+    std::exception_ptr first;
+    std::vector<BatchQueue*> queues;
+
+public:
+    explicit StageFailure(const std::vector<BatchQueue*>& queues) : queues(queues) {}
+
+    void record(std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!first) {
+                first = error;
+            }
+        }
+        for (BatchQueue* queue : queues) {
+            queue->close();
+        }
+    }
+
+    // Only called once every stage thread has been joined
+    void rethrow() const {
+        if (first) {
+            std::rethrow_exception(first);
+        }
+    }
+};
+
+void addQueueStats(IngestReport& report, const char* name, const BatchQueue& queue) {
+    QueueStats stats;
+    stats.name = name;
+    stats.capacity = queue.capacity();
+    stats.highWater = queue.highWaterMark();
+    stats.fullWaits = queue.fullWaitCount();
+    report.queues.push_back(stats);
+}
+
+}
+
+IngestReport::IngestReport() : bytes(0), rows(0), applied(0), rejected(0), seconds(0.0) {
+}
+
+IngestReport ingestTransactions(const std::string& feed, const AccountIndex& index,
+                                TransferEngine& transfers) {
+    const ExchangeFormat format = exchangeFormatFor(feed);
+    std::ifstream file(feed, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + feed);
+    }
+
+    const std::string rejectedPath = feed + ".rejected";
+    std::remove(rejectedPath.c_str());
+
+    IngestReport report;
+    const char* names[] = { "reader", "parser", "validator", "applier" };
+    for (const char* name : names) {
+        StageStats stage;
+        stage.name = name;
+        stage.items = 0;
+        stage.busySeconds = 0.0;
+        report.stages.push_back(stage);
+    }
+
+    BatchQueue parseQueue(INGEST_QUEUE_CAPACITY);
+    BatchQueue validateQueue(INGEST_QUEUE_CAPACITY);
+    BatchQueue applyQueue(INGEST_QUEUE_CAPACITY);
+    std::string readError;
+
+    StageFailure failure({ &parseQueue, &validateQueue, &applyQueue });
+    std::vector<std::thread> workers;
+
+    Clock::time_point start = Clock::now();
+    try {
+        workers.push_back(std::thread([&]() {
+            try {
+                readStage(file, parseQueue, report.stages[0], readError);
+            } catch (...) {
+                failure.record(std::current_exception());
+            }
+        }));
+        workers.push_back(std::thread([&]() {
+            try {
+                parseStage(format, parseQueue, validateQueue, report.stages[1]);
+            } catch (...) {
+                failure.record(std::current_exception());
+            }
+        }));
+        workers.push_back(std::thread([&]() {
+            try {
+                validateStage(index, validateQueue, applyQueue, report.stages[2]);
+            } catch (...) {
+                failure.record(std::current_exception());
+            }
+        }));
+        applyStage(transfers, rejectedPath, applyQueue, report, report.stages[3]);
+    } catch (...) {
+        // The applier or a thread start failed; the started stages still have to be joined
+        failure.record(std::current_exception());
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    failure.rethrow();
+    report.seconds = secondsSince(start);
+
+    report.bytes = report.stages[0].items;
+    report.rows = report.stages[3].items;
+    if (!readError.empty()) {
+        report.error = readError;
+    }
+    addQueueStats(report, "reader->parser", parseQueue);
+    addQueueStats(report, "parser->validator", validateQueue);
+    addQueueStats(report, "validator->applier", applyQueue);
+    return report;
+}
+
+void printIngestReport(const IngestReport& report, std::ostream& out) {
+    out << "Applied " << report.applied << " of " << report.rows << " rows, rejected "
+        << report.rejected << " (" << std::fixed << std::setprecision(1)
+        << report.bytes / 1048576.0 << " MB in " << std::setprecision(3) << report.seconds << " s)\n";
+
+    out << std::left << std::setw(20) << "Stage" << std::right << std::setw(14) << "Items"
+        << std::setw(10) << "Busy s" << std::setw(16) << "Items/s" << "\n";
+    for (const auto& stage : report.stages) {
+        double rate = stage.busySeconds > 0 ? stage.items / stage.busySeconds : 0.0;
+        out << std::left << std::setw(20) << stage.name << std::right << std::setw(14) << stage.items
+            << std::setw(10) << std::setprecision(3) << stage.busySeconds
+            << std::setw(16) << std::setprecision(0) << rate << "\n";
+    }
+
+    out << std::left << std::setw(20) << "Queue" << std::right << std::setw(14) << "High water"
+        << std::setw(10) << "Capacity" << std::setw(16) << "Full waits" << "\n";
+    for (const auto& queue : report.queues) {
+        out << std::left << std::setw(20) << queue.name << std::right << std::setw(14) << queue.highWater
+            << std::setw(10) << queue.capacity << std::setw(16) << queue.fullWaits << "\n";
+    }
+
+    for (const auto& error : report.errors) {
+        out << "  " << error << "\n";
+    }
+    if (!report.rejectedFile.empty()) {
+        out << "  Rejected rows written to " << report.rejectedFile << "\n";
+    }
+}
@@ -0,0 +1,110 @@
+#include "MemoryReport.h"
+#include <iomanip>
+#include <cstring>
+
+namespace {
+
+void printLine(const char* part, size_t bytes, size_t total, std::ostream& out) {
+    out << std::left << std::setw(30) << part << std::right << std::setw(16) << bytes
+        << std::setw(12) << std::setprecision(2) << bytes / 1048576.0
+        << std::setw(8) << std::setprecision(1)
+        << (total > 0 ? 100.0 * static_cast<double>(bytes) / static_cast<double>(total) : 0.0) << "%\n";
+}
+
+void measureAccounts(const std::vector<BankAccount>& accounts, MemoryReport& report) {
+    report.accounts = accounts.size();
+    report.objectBytes = accounts.capacity() * sizeof(BankAccount);
+    for (const auto& account : accounts) {
+        const size_t depositSlack = static_cast<size_t>(account.getDepositedCapacity() - account.getDepositedCount());
+        const size_t withdrawalSlack = static_cast<size_t>(account.getWithdrawnCapacity() - account.getWithdrawnCount());
+        report.codeBytes += std::strlen(account.getUniqueCode()) + 1;
+        report.nameBytes += std::strlen(account.getOwnerName()) + 1;
+        report.depositBytes += static_cast<size_t>(account.getDepositedCount()) * sizeof(double);
+        report.withdrawalBytes += static_cast<size_t>(account.getWithdrawnCount()) * sizeof(double);
+        report.depositSlack += depositSlack * sizeof(double);
+        report.withdrawalSlack += withdrawalSlack * sizeof(double);
+        if (account.getRecentTransactions() > 0) {
+            ++report.activeAccounts;
+        }
+        if (account.isDormant()) {
+            report.dormantSlack += (depositSlack + withdrawalSlack) * sizeof(double);
+        }
+    }
+}
+
+}
+
+MemoryReport::MemoryReport()
+    : accounts(0), activeAccounts(0), objectBytes(0), codeBytes(0), nameBytes(0),
+      depositBytes(0), withdrawalBytes(0), depositSlack(0), withdrawalSlack(0),
+      dormantSlack(0), indexBytes(0), snapshotBytes(0) {
+}
+
+size_t MemoryReport::accountBytes() const {
+    return objectBytes + codeBytes + nameBytes + depositBytes + withdrawalBytes +
+           depositSlack + withdrawalSlack;
+}
+
+size_t MemoryReport::total() const {
+    return accountBytes() + indexBytes + snapshotBytes;
+}
+
+MemoryReport measureMemory(const std::vector<BankAccount>& accounts, const AccountIndex& index,
+                           const BookSnapshot& snapshot) {
+    MemoryReport report;
+    measureAccounts(accounts, report);
+    report.indexBytes = index.memoryUsage();
+    report.snapshotBytes = snapshot.memoryUsage();
+    return report;
+}
+
+void printMemoryReport(const MemoryReport& report, std::ostream& out) {
+    const size_t total = report.total();
+    out << std::fixed << std::left << std::setw(30) << "Part" << std::right << std::setw(16) << "Bytes"
+        << std::setw(12) << "MB" << std::setw(9) << "Share" << "\n";
+    printLine("Account objects", report.objectBytes, total, out);
+    printLine("Account codes", report.codeBytes, total, out);
+    printLine("Owner names", report.nameBytes, total, out);
+    printLine("Deposit amounts", report.depositBytes, total, out);
+    printLine("Withdrawal amounts", report.withdrawalBytes, total, out);
+    printLine("Deposit array slack", report.depositSlack, total, out);
+    printLine("Withdrawal array slack", report.withdrawalSlack, total, out);
+    printLine("Code and owner index", report.indexBytes, total, out);
+    printLine("Snapshot (current version)", report.snapshotBytes, total, out);
+    printLine("Total", total, total, out);
+
+    out << report.accounts << " accounts, " << report.activeAccounts
+        << " with transactions since loading or the last compaction\n"
+        << "Slack held by dormant accounts: " << std::setprecision(2)
+        << report.dormantSlack / 1048576.0 << " MB (freed by compaction)\n";
+}
+
+CompactionResult compactAccounts(std::vector<BankAccount>& accounts) {
+    CompactionResult result;
+    MemoryReport before;
+    measureAccounts(accounts, before);
+    result.bytesBefore = before.accountBytes();
+    result.dormant = 0;
+    result.active = 0;
+
+    for (auto& account : accounts) {
+        ++(account.compact() ? result.dormant : result.active);
+    }
+    accounts.shrink_to_fit();
+
+    MemoryReport after;
+    measureAccounts(accounts, after);
+    result.bytesAfter = after.accountBytes();
+    return result;
+}
+
+void printCompactionResult(const CompactionResult& result, std::ostream& out) {
+    out << std::fixed << std::setprecision(2) << "[OK] Compacted " << result.dormant
+        << " dormant and " << result.active << " active accounts: "
+        << result.bytesBefore / 1048576.0 << " MB -> " << result.bytesAfter / 1048576.0 << " MB (";
+    if (result.bytesAfter <= result.bytesBefore) {
+        out << (result.bytesBefore - result.bytesAfter) / 1048576.0 << " MB freed)\n";
+    } else {
+        out << (result.bytesAfter - result.bytesBefore) / 1048576.0 << " MB more as headroom)\n";
+    }
+}
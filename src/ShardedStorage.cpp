@@ -0,0 +1,435 @@
+#include "ShardedStorage.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <cstdio>
+#include "AccountStorage.h"
+#include "Checksum.h"
+
+namespace {
+
+std::string baseName(const std::string& manifest) {
+    size_t slash = manifest.find_last_of("/\\");
+    size_t dot = manifest.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return manifest;
+    }
+    return manifest.substr(0, dot);
+}
+
+// Replaces `target` with `temporary`; Windows cannot rename over an existing file
+bool replaceFile(const std::string& temporary, const std::string& target) {
+    if (std::rename(temporary.c_str(), target.c_str()) == 0) {
+        return true;
+    }
+    std::remove(target.c_str());
+    return std::rename(temporary.c_str(), target.c_str()) == 0;
+}
+
+// "dir/bank_accounts.manifest" -> "dir/bank_accounts.dat", the single-file layout of the same book
+std::string singleFileName(const std::string& manifest) {
+    return baseName(manifest) + ".dat";
+}
+
+bool fileExists(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return file.is_open();
+}
+
+unsigned long long fileSize(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file ? static_cast<unsigned long long>(file.tellg()) : 0;
+}
+
+// Manifest payload: the shard count, then "<file> <accounts> <bytes> <crc>" per shard
+bool readManifest(const std::string& manifest, std::vector<ShardStatus>& entries) {
+    std::ifstream file(manifest, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    ChecksumReport verification = verifyChecksums(manifest);
+    if (!verification.hasChecksums || !verification.valid) {
+        throw std::runtime_error("Shard manifest \"" + manifest + "\" is corrupted");
+    }
+
+    size_t shardCount = 0;
+    if (!(file >> shardCount) || shardCount == 0 || shardCount > MAX_SHARDS) {
+        throw std::runtime_error("Shard manifest \"" + manifest + "\" has a bad shard count");
+    }
+    entries.assign(shardCount, ShardStatus());
+    for (auto& entry : entries) {
+        if (!(file >> entry.filename >> entry.accounts >> entry.bytes >> std::hex >> entry.crc >> std::dec)) {
+            throw std::runtime_error("Shard manifest \"" + manifest + "\" is truncated");
+        }
+    }
+    return true;
+}
+
+void writeManifest(const std::string& manifest, const std::vector<ShardStatus>& entries) {
+    const std::string temporary = manifest + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot create " + temporary);
+        }
+        ChecksumStreamBuf checksummed(file.rdbuf());
+        std::ostream out(&checksummed);
+
+        out << entries.size() << "\n";
+        for (const auto& entry : entries) {
+            out << entry.filename << " " << entry.accounts << " " << entry.bytes << " "
+                << std::hex << std::setw(8) << std::setfill('0') << entry.crc
+                << std::dec << std::setfill(' ') << "\n";
+        }
+        if (!out || !checksummed.finish()) {
+            throw std::runtime_error("Cannot write " + temporary);
+        }
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Cannot write " + temporary);
+        }
+    }
+    if (!replaceFile(temporary, manifest)) {
+        throw std::runtime_error("Cannot replace " + manifest);
+    }
+}
+
+// Forwards everything to `target`, keeping a running CRC32C and byte count
+class CrcForwardingBuf : public std::streambuf {
+private:
+    std::streambuf* target;
+    uint32_t crc;
+    unsigned long long bytes;
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        std::streamsize written = target->sputn(data, count);
+        if (written > 0) {
+            crc = crc32c(data, static_cast<size_t>(written), crc);
+            bytes += static_cast<unsigned long long>(written);
+        }
+        return written;
+    }
+
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    int sync() override {
+        return target->pubsync();
+    }
+
+public:
+    explicit CrcForwardingBuf(std::streambuf* target) : target(target), crc(0), bytes(0) {}
+
+    uint32_t checksum() const { return crc; }
+    unsigned long long size() const { return bytes; }
+};
+
+// Streams one shard to its temporary file, checksumming it on the way, and
+// replaces the old file with it
+void saveShard(const std::vector<BankAccount>& accounts, const std::vector<size_t>& members,
+               ShardStatus& status) {
+    const std::string temporary = status.filename + ".tmp";
+    try {
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Cannot create " + temporary);
+            }
+            CrcForwardingBuf counted(file.rdbuf());
+            ChecksumStreamBuf checksummed(&counted);
+            std::ostream out(&checksummed);
+
+            out << members.size() << "\n";
+            for (size_t position : members) {
+                accounts[position].saveToFile(out);
+            }
+            if (!out || !checksummed.finish()) {
+                throw std::runtime_error("Cannot write " + temporary);
+            }
+            file.close();
+            if (!file) {
+                throw std::runtime_error("Cannot write " + temporary);
+            }
+            status.accounts = members.size();
+            status.bytes = counted.size();
+            status.crc = counted.checksum();
+        }
+        if (!replaceFile(temporary, status.filename)) {
+            throw std::runtime_error("Cannot replace " + status.filename);
+        }
+        status.written = true;
+    } catch (const std::exception& e) {
+        std::remove(temporary.c_str());
+        status.error = e.what();
+    }
+}
+
+void loadShard(size_t shard, size_t shardCount, const ShardStatus& expected,
+               std::vector<BankAccount>& accounts, ShardStatus& status) {
+    try {
+        ChecksumReport verification;
+        if (!loadAccountsFile(status.filename, accounts, &verification)) {
+            throw std::runtime_error("Shard file is missing");
+        }
+        if (!verification.hasChecksums) {
+            throw std::runtime_error("Shard file has no checksums");
+        }
+        for (const auto& account : accounts) {
+            if (shardOf(account.getUniqueCode(), shardCount) != shard) {
+                throw std::runtime_error(std::string("Account ") + account.getUniqueCode() +
+                                         " belongs to another shard");
+            }
+        }
+
+        status.accounts = accounts.size();
+        status.bytes = fileSize(status.filename);
+        if (status.accounts != expected.accounts || status.bytes != expected.bytes) {
+            // Saved after the manifest was last written; the shard's own checksums still
+            // hold. The next save rewrites it so the manifest catches up.
+            status.warning = "Shard differs from the manifest";
+            for (auto& account : accounts) {
+                account.setUnsavedChanges(true);
+            }
+        }
+    } catch (const std::exception& e) {
+        accounts.clear();
+        status.error = e.what();
+    }
+}
+
+// Loads the shards of `entries` in parallel; failed shards are left out of `accounts`
+void loadShardFiles(const std::string& manifest, const std::vector<ShardStatus>& entries,
+                    std::vector<BankAccount>& accounts, ShardReport& report) {
+    const size_t shardCount = entries.size();
+    report.shards.assign(shardCount, ShardStatus());
+    std::vector<std::vector<BankAccount>> loaded(shardCount);
+    std::vector<std::thread> workers;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        report.shards[shard].filename = shardFileName(manifest, shard, shardCount);
+        workers.push_back(std::thread(loadShard, shard, shardCount, std::cref(entries[shard]),
+                                      std::ref(loaded[shard]), std::ref(report.shards[shard])));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t total = 0;
+    for (const auto& shard : loaded) {
+        total += shard.size();
+    }
+    std::vector<BankAccount> merged;
+    merged.reserve(total);
+    for (auto& shard : loaded) {
+        for (auto& account : shard) {
+            merged.push_back(std::move(account));
+        }
+    }
+    accounts.swap(merged);
+}
+
+}
+
+ShardStatus::ShardStatus() : accounts(0), bytes(0), crc(0), written(false) {
+}
+
+size_t ShardReport::failedCount() const {
+    size_t failed = 0;
+    for (const auto& shard : shards) {
+        if (!shard.error.empty()) ++failed;
+    }
+    return failed;
+}
+
+size_t ShardReport::writtenCount() const {
+    size_t written = 0;
+    for (const auto& shard : shards) {
+        if (shard.written) ++written;
+    }
+    return written;
+}
+
+size_t shardOf(const char* uniqueCode, size_t shardCount) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = uniqueCode; *p; ++p) {
+        hash ^= static_cast<unsigned char>(*p);
+        hash *= 16777619u;
+    }
+    return hash % shardCount;
+}
+
+std::string shardFileName(const std::string& manifest, size_t shard, size_t shardCount) {
+    std::ostringstream name;
+    name << baseName(manifest) << ".shard-" << std::setw(2) << std::setfill('0') << shard
+         << "-of-" << std::setw(2) << shardCount << ".dat";
+    return name.str();
+}
+
+size_t readShardCount(const std::string& manifest) {
+    std::vector<ShardStatus> entries;
+    return readManifest(manifest, entries) ? entries.size() : 0;
+}
+
+ShardReport saveShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                       size_t shardCount) {
+    if (shardCount == 0 || shardCount > MAX_SHARDS) {
+        throw std::invalid_argument("Shard count must be between 1 and " + std::to_string(MAX_SHARDS));
+    }
+
+    std::vector<ShardStatus> previous;
+    readManifest(manifest, previous);
+    const bool sameLayout = previous.size() == shardCount;
+
+    // A shard is rewritten when the layout changed, it gained accounts, or one
+    // of its accounts changed since it was loaded or saved
+    std::vector<std::vector<size_t>> members(shardCount);
+    std::vector<bool> dirty(shardCount, !sameLayout);
+    for (size_t i = 0; i < accounts.size(); ++i) {
+        const size_t shard = shardOf(accounts[i].getUniqueCode(), shardCount);
+        members[shard].push_back(i);
+        if (accounts[i].hasUnsavedChanges()) {
+            dirty[shard] = true;
+        }
+    }
+
+    ShardReport report;
+    report.shards.resize(shardCount);
+    std::vector<std::thread> workers;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        if (sameLayout && !dirty[shard] && previous[shard].accounts == members[shard].size()) {
+            report.shards[shard] = previous[shard];
+            continue;
+        }
+        report.shards[shard].filename = shardFileName(manifest, shard, shardCount);
+        workers.push_back(std::thread(saveShard, std::cref(accounts), std::cref(members[shard]),
+                                      std::ref(report.shards[shard])));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (report.failedCount() > 0 && !sameLayout) {
+        // The old manifest still describes the old, untouched shard files; new ones would be orphans
+        for (const auto& shard : report.shards) {
+            if (shard.written) {
+                std::remove(shard.filename.c_str());
+            }
+        }
+        return report;
+    }
+
+    std::vector<ShardStatus> entries(report.shards);
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        if (!entries[shard].error.empty()) {
+            entries[shard] = previous[shard];
+        }
+    }
+    writeManifest(manifest, entries);
+
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        if (report.shards[shard].written) {
+            for (size_t position : members[shard]) {
+                accounts[position].setUnsavedChanges(false);
+            }
+        }
+    }
+    if (!sameLayout) {
+        for (const auto& old : previous) {
+            std::remove(old.filename.c_str());
+        }
+    }
+    if (report.failedCount() == 0) {
+        // The shards now hold the whole book; a stale single file must never be loaded again
+        std::remove(singleFileName(manifest).c_str());
+    }
+    return report;
+}
+
+bool loadShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                ShardReport& report) {
+    std::vector<ShardStatus> entries;
+    if (!readManifest(manifest, entries)) {
+        return false;
+    }
+    loadShardFiles(manifest, entries, accounts, report);
+    return true;
+}
+
+bool recoverShards(const std::string& manifest, std::vector<BankAccount>& accounts,
+                   ShardReport& report) {
+    // Exactly one layout may have files on disk, and it must have all of them
+    size_t shardCount = 0;
+    for (size_t count = 1; count <= MAX_SHARDS; ++count) {
+        size_t present = 0;
+        for (size_t shard = 0; shard < count; ++shard) {
+            if (fileExists(shardFileName(manifest, shard, count))) ++present;
+        }
+        if (present == 0) {
+            continue;
+        }
+        if (present != count || shardCount != 0) {
+            return false;
+        }
+        shardCount = count;
+    }
+    if (shardCount == 0) {
+        return false;
+    }
+
+    std::vector<ShardStatus> entries(shardCount);
+    std::vector<BankAccount> recovered;
+    ShardReport loaded;
+    loadShardFiles(manifest, entries, recovered, loaded);
+    if (loaded.failedCount() > 0) {
+        report = loaded;
+        return false;
+    }
+
+    // There was no manifest to compare against. The file CRCs stay 0 and every
+    // account counts as changed, so the next save rewrites every shard.
+    for (auto& shard : loaded.shards) {
+        shard.warning.clear();
+    }
+    for (auto& account : recovered) {
+        account.setUnsavedChanges(true);
+    }
+    const std::string aside = manifest + ".corrupt";
+    std::remove(aside.c_str());
+    std::rename(manifest.c_str(), aside.c_str());
+    writeManifest(manifest, loaded.shards);
+
+    accounts.swap(recovered);
+    report = loaded;
+    return true;
+}
+
+std::vector<std::string> missingShards(const std::string& manifest) {
+    std::vector<ShardStatus> entries;
+    std::vector<std::string> missing;
+    if (readManifest(manifest, entries)) {
+        for (const auto& entry : entries) {
+            if (!fileExists(entry.filename)) {
+                missing.push_back(entry.filename);
+            }
+        }
+    }
+    return missing;
+}
+
+void removeShards(const std::string& manifest) {
+    std::vector<ShardStatus> entries;
+    if (readManifest(manifest, entries)) {
+        for (const auto& entry : entries) {
+            std::remove(entry.filename.c_str());
+        }
+    }
+    std::remove(manifest.c_str());
+}
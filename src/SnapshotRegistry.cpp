@@ -0,0 +1,140 @@
+#include "SnapshotRegistry.h"
+#include <stdexcept>
+#include "HeapBytes.h"
+
+const size_t BookSnapshot::CHUNK_SIZE;
+
+BookSnapshot::BookSnapshot() : accountCount(0), version(0) {
+}
+
+size_t BookSnapshot::size() const {
+    return accountCount;
+}
+
+bool BookSnapshot::empty() const {
+    return accountCount == 0;
+}
+
+unsigned long long BookSnapshot::getVersion() const {
+    return version;
+}
+
+const AccountSnapshot& BookSnapshot::operator[](size_t index) const {
+    return (*chunks[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+}
+
+void BookSnapshot::collectTotals(std::vector<double>& deposited, std::vector<double>& withdrawn) const {
+    deposited.clear();
+    withdrawn.clear();
+    deposited.reserve(accountCount);
+    withdrawn.reserve(accountCount);
+    for (const auto& chunk : chunks) {
+        for (const auto& account : *chunk) {
+            deposited.push_back(account.totalDeposited);
+            withdrawn.push_back(account.totalWithdrawn);
+        }
+    }
+}
+
+size_t BookSnapshot::memoryUsage() const {
+    size_t bytes = chunks.capacity() * sizeof(chunks[0]);
+    for (const auto& chunk : chunks) {
+        bytes += sizeof(*chunk) + chunk->capacity() * sizeof(AccountSnapshot);
+        for (const auto& account : *chunk) {
+            // Counted in every version that shares them
+            bytes += 2 * sizeof(std::string) + heapBytes(*account.uniqueCode) + heapBytes(*account.ownerName);
+        }
+    }
+    return bytes;
+}
+
+SnapshotRegistry::SnapshotRegistry() : current(std::make_shared<BookSnapshot>()) {
+}
+
+void SnapshotRegistry::summarize(const BankAccount& account, AccountSnapshot& entry) {
+    if (!entry.uniqueCode || *entry.uniqueCode != account.getUniqueCode()) {
+        entry.uniqueCode = std::make_shared<const std::string>(account.getUniqueCode());
+    }
+    if (!entry.ownerName || *entry.ownerName != account.getOwnerName()) {
+        entry.ownerName = std::make_shared<const std::string>(account.getOwnerName());
+    }
+    // Totals and statistics are maintained by the account, so this is O(1)
+    entry.depositedCount = account.getDepositedCount();
+    entry.withdrawnCount = account.getWithdrawnCount();
+    entry.totalDeposited = account.getTotalDeposited();
+    entry.totalWithdrawn = account.getTotalWithdrawn();
+    entry.depositStats = account.getDepositStats();
+    entry.withdrawalStats = account.getWithdrawalStats();
+}
+
+std::shared_ptr<const BookSnapshot> SnapshotRegistry::acquire() const {
+    return std::atomic_load(&current);
+}
+
+void SnapshotRegistry::publishAll(const std::vector<BankAccount>& accounts) {
+    std::lock_guard<std::mutex> guard(writerMutex);
+
+    std::shared_ptr<BookSnapshot> next = std::make_shared<BookSnapshot>();
+    next->version = current->version + 1;
+    next->accountCount = accounts.size();
+
+    for (size_t start = 0; start < accounts.size(); start += BookSnapshot::CHUNK_SIZE) {
+        std::shared_ptr<std::vector<AccountSnapshot>> chunk = std::make_shared<std::vector<AccountSnapshot>>();
+        chunk->reserve(BookSnapshot::CHUNK_SIZE);
+        for (size_t i = start; i < accounts.size() && i < start + BookSnapshot::CHUNK_SIZE; ++i) {
+            chunk->push_back(AccountSnapshot());
+            summarize(accounts[i], chunk->back());
+        }
+        next->chunks.push_back(chunk);
+    }
+
+    std::atomic_store(&current, std::shared_ptr<const BookSnapshot>(next));
+}
+
+void SnapshotRegistry::publish(const std::vector<BankAccount>& accounts, const std::vector<size_t>& changed) {
+    std::lock_guard<std::mutex> guard(writerMutex);
+
+    const BookSnapshot& previous = *current;
+    if (accounts.size() < previous.accountCount) {
+        throw std::logic_error("Accounts were removed; publish the whole book instead");
+    }
+
+    std::shared_ptr<BookSnapshot> next = std::make_shared<BookSnapshot>();
+    next->version = previous.version + 1;
+    next->accountCount = accounts.size();
+    next->chunks = previous.chunks;
+
+    // Chunks copied for this version; untouched chunks stay shared with the previous one
+    std::vector<std::shared_ptr<std::vector<AccountSnapshot>>> owned(
+        (accounts.size() + BookSnapshot::CHUNK_SIZE - 1) / BookSnapshot::CHUNK_SIZE);
+
+    auto writableChunk = [&](size_t chunkIndex) -> std::vector<AccountSnapshot>& {
+        if (!owned[chunkIndex]) {
+            std::shared_ptr<std::vector<AccountSnapshot>> copy = std::make_shared<std::vector<AccountSnapshot>>();
+            copy->reserve(BookSnapshot::CHUNK_SIZE);
+            if (chunkIndex < next->chunks.size()) {
+                copy->assign(next->chunks[chunkIndex]->begin(), next->chunks[chunkIndex]->end());
+                next->chunks[chunkIndex] = copy;
+            } else {
+                next->chunks.push_back(copy);
+            }
+            owned[chunkIndex] = copy;
+        }
+        return *owned[chunkIndex];
+    };
+
+    for (size_t index : changed) {
+        if (index >= previous.accountCount) {
+            continue; // Covered by the appended range below
+        }
+        summarize(accounts[index], writableChunk(index / BookSnapshot::CHUNK_SIZE)[index % BookSnapshot::CHUNK_SIZE]);
+    }
+
+    for (size_t index = previous.accountCount; index < accounts.size(); ++index) {
+        std::vector<AccountSnapshot>& chunk = writableChunk(index / BookSnapshot::CHUNK_SIZE);
+        chunk.push_back(AccountSnapshot());
+        summarize(accounts[index], chunk.back());
+    }
+
+    std::atomic_store(&current, std::shared_ptr<const BookSnapshot>(next));
+}
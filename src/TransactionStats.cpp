@@ -0,0 +1,162 @@
+#include "TransactionStats.h"
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include "DatReader.h"
+
+TransactionStats::TransactionStats()
+    : count(0), mean(0.0), m2(0.0), min(0.0), max(0.0), last(0.0), largeCount(0),
+      earlierMean(0.0), earlierM2(0.0) {
+}
+
+void TransactionStats::add(double amount) {
+    earlierMean = mean;
+    earlierM2 = m2;
+    ++count;
+    double delta = amount - mean;
+    mean += delta / count;
+    m2 += delta * (amount - mean);
+
+    if (count == 1 || amount < min) min = amount;
+    if (count == 1 || amount > max) max = amount;
+    last = amount;
+    if (amount >= LARGE_TRANSACTION_AMOUNT) {
+        ++largeCount;
+    }
+}
+
+double TransactionStats::variance() const {
+    return count > 1 ? m2 / count : 0.0;
+}
+
+double TransactionStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+bool TransactionStats::earlierMoments(double& meanBefore, double& stddevBefore) const {
+    const int history = count - 1;
+    if (history < MIN_ANOMALY_HISTORY) {
+        return false;
+    }
+    meanBefore = earlierMean;
+    stddevBefore = earlierM2 > 0 ? std::sqrt(earlierM2 / history) : 0.0;
+    return true;
+}
+
+double TransactionStats::lastDeviation() const {
+    double previousMean, previousStddev;
+    if (!earlierMoments(previousMean, previousStddev)) {
+        return 0.0;
+    }
+
+    // Spreads below rounding noise count as "all earlier amounts were equal"
+    double distance = std::fabs(last - previousMean);
+    double noise = std::fabs(previousMean) * 1e-12;
+    if (previousStddev <= noise) {
+        return distance <= noise ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+    return distance / previousStddev;
+}
+
+TransactionStats TransactionStats::of(const double* amounts, int count) {
+    TransactionStats stats;
+    for (int i = 0; i < count; ++i) {
+        stats.add(amounts[i]);
+    }
+    return stats;
+}
+
+bool TransactionStats::describes(const double* amounts, int amountCount) const {
+    if (count != amountCount) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    double sum = 0.0;
+    double lowest = amounts[0];
+    double highest = amounts[0];
+    for (int i = 0; i < count; ++i) {
+        sum += amounts[i];
+        lowest = std::min(lowest, amounts[i]);
+        highest = std::max(highest, amounts[i]);
+    }
+    // Welford's mean and a plain sum disagree only by rounding
+    const double tolerance = 1e-9 * std::max(std::fabs(lowest), std::fabs(highest));
+    return last == amounts[count - 1] && min == lowest && max == highest &&
+           std::fabs(mean - sum / count) <= tolerance;
+}
+
+namespace {
+
+void writeGroup(std::ostream& os, const TransactionStats& stats) {
+    os << " " << stats.count << " " << stats.mean << " " << stats.m2 << " " << stats.min
+       << " " << stats.max << " " << stats.last << " " << stats.largeCount
+       << " " << stats.earlierMean << " " << stats.earlierM2;
+}
+
+bool nextToken(const char*& p, const char* end, const char*& tokenStart, const char*& tokenEnd) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    tokenStart = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+    tokenEnd = p;
+    return tokenStart < tokenEnd;
+}
+
+bool parseGroup(const char*& p, const char* end, TransactionStats& stats) {
+    const char* start;
+    const char* stop;
+    long long count, largeCount;
+    double* amounts[] = { &stats.mean, &stats.m2, &stats.min, &stats.max, &stats.last };
+
+    if (!nextToken(p, end, start, stop) || !parseInteger(start, stop, count) ||
+        count < 0 || count > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    for (double* amount : amounts) {
+        if (!nextToken(p, end, start, stop) || !parseAmount(start, stop, *amount)) {
+            return false;
+        }
+    }
+    if (!nextToken(p, end, start, stop) || !parseInteger(start, stop, largeCount) ||
+        largeCount < 0 || largeCount > count) {
+        return false;
+    }
+    if (!nextToken(p, end, start, stop) || !parseAmount(start, stop, stats.earlierMean) ||
+        !nextToken(p, end, start, stop) || !parseAmount(start, stop, stats.earlierM2)) {
+        return false;
+    }
+    stats.count = static_cast<int>(count);
+    stats.largeCount = static_cast<int>(largeCount);
+    return true;
+}
+
+}
+
+void writeStatsLine(std::ostream& os, const TransactionStats& deposits,
+                    const TransactionStats& withdrawals) {
+    // Full precision so reloaded statistics continue exactly where they left off
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision(17);
+    os.unsetf(std::ios::floatfield);
+    os << "@stats";
+    writeGroup(os, deposits);
+    writeGroup(os, withdrawals);
+    os << "\n";
+    os.precision(precision);
+    os.flags(flags);
+}
+
+bool parseStatsLine(const char* text, size_t length, TransactionStats& deposits,
+                    TransactionStats& withdrawals) {
+    const char* end = text + length;
+    if (length < 6 || std::memcmp(text, "@stats", 6) != 0) {
+        return false;
+    }
+    const char* p = text + 6;
+    const char* start;
+    const char* stop;
+    return parseGroup(p, end, deposits) && parseGroup(p, end, withdrawals) &&
+           !nextToken(p, end, start, stop);
+}
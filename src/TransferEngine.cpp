@@ -0,0 +1,206 @@
+#include "TransferEngine.h"
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include "DatReader.h"
+
+namespace {
+
+struct AccountTally {
+    int deposits;
+    int withdrawals;
+    double inflow;
+    double outflow;
+
+    AccountTally() : deposits(0), withdrawals(0), inflow(0.0), outflow(0.0) {}
+};
+
+}
+
+const size_t TransferEngine::LOCK_STRIPES;
+
+TransferEngine::TransferEngine(std::vector<BankAccount>& accounts, SnapshotRegistry* snapshots,
+                               const std::string& journalPath)
+    : accounts(accounts), snapshots(snapshots), journalPath(journalPath), nextBatchId(1) {
+}
+
+void TransferEngine::validateBatch(const std::vector<Transfer>& batch) const {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const Transfer& transfer = batch[i];
+        std::ostringstream where;
+        where << "Transfer #" << (i + 1) << ": ";
+
+        if (transfer.fromIndex >= accounts.size() || transfer.toIndex >= accounts.size()) {
+            throw std::invalid_argument(where.str() + "account does not exist");
+        }
+        if (transfer.fromIndex == transfer.toIndex) {
+            throw std::invalid_argument(where.str() + "source and destination are the same account");
+        }
+        if (!std::isfinite(transfer.amount) || transfer.amount <= 0) {
+            throw std::invalid_argument(where.str() + "amount must be a positive number");
+        }
+    }
+}
+
+unsigned long long TransferEngine::writeJournalRecord(const std::vector<Transfer>& batch) {
+    std::lock_guard<std::mutex> guard(journalMutex);
+
+    if (!journal.is_open()) {
+        journal.open(journalPath, std::ios::app);
+        if (!journal) {
+            throw std::runtime_error("Cannot open transfer journal");
+        }
+    }
+
+    // The whole batch goes out as one record with a single write and flush
+    unsigned long long batchId = nextBatchId;
+    std::ostringstream record;
+    record << "BATCH " << batchId << " " << batch.size() << "\n";
+    char amount[32];
+    for (const auto& transfer : batch) {
+        record << accounts[transfer.fromIndex].getUniqueCode() << " "
+               << accounts[transfer.toIndex].getUniqueCode() << " ";
+        record.write(amount, static_cast<std::streamsize>(formatAmount(transfer.amount, amount))) << "\n";
+    }
+    record << "END " << batchId << "\n";
+
+    const std::string text = record.str();
+    journal.write(text.data(), static_cast<std::streamsize>(text.size()));
+    journal.flush();
+    if (!journal) {
+        journal.close();
+        throw std::runtime_error("Cannot write transfer journal");
+    }
+
+    ++nextBatchId;
+    return batchId;
+}
+
+unsigned long long TransferEngine::applyBatch(const std::vector<Transfer>& batch) {
+    if (batch.empty()) {
+        return 0;
+    }
+
+    validateBatch(batch);
+
+    std::unordered_map<size_t, AccountTally> tallies;
+    tallies.reserve(batch.size() * 2);
+    for (const auto& transfer : batch) {
+        AccountTally& from = tallies[transfer.fromIndex];
+        from.withdrawals++;
+        from.outflow += transfer.amount;
+
+        AccountTally& to = tallies[transfer.toIndex];
+        to.deposits++;
+        to.inflow += transfer.amount;
+    }
+
+    std::vector<size_t> touched;
+    touched.reserve(tallies.size());
+    for (const auto& pair : tallies) {
+        touched.push_back(pair.first);
+    }
+    std::vector<std::unique_lock<std::mutex>> locks = lockAccounts(touched);
+
+    // Transfers that are fine on their own may still overdraw an account together
+    for (const auto& pair : tallies) {
+        const AccountTally& tally = pair.second;
+        if (tally.outflow > 0 &&
+            accounts[pair.first].getBalance() + tally.inflow - tally.outflow < 0) {
+            throw std::runtime_error(std::string("Conflicting transfers: batch would overdraw account ") +
+                                     accounts[pair.first].getUniqueCode());
+        }
+    }
+
+    // Everything that can fail happens before the first posting
+    for (const auto& pair : tallies) {
+        accounts[pair.first].reserveTransactions(pair.second.deposits, pair.second.withdrawals);
+    }
+    unsigned long long batchId = writeJournalRecord(batch);
+
+    for (const auto& transfer : batch) {
+        accounts[transfer.fromIndex].addWithdrawal(transfer.amount);
+        accounts[transfer.toIndex].addDeposit(transfer.amount);
+    }
+
+    // Published while the stripes are still held so readers see the batch whole or not at all
+    if (snapshots) {
+        snapshots->publish(accounts, touched);
+    }
+
+    return batchId;
+}
+
+void TransferEngine::applyPostings(const std::vector<Posting>& postings) {
+    if (postings.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < postings.size(); ++i) {
+        if (postings[i].accountIndex >= accounts.size()) {
+            throw std::invalid_argument("Posting #" + std::to_string(i + 1) + ": account does not exist");
+        }
+        if (!std::isfinite(postings[i].amount) || postings[i].amount < 0) {
+            throw std::invalid_argument("Posting #" + std::to_string(i + 1) +
+                                        ": amount must be a finite, non-negative number");
+        }
+    }
+
+    // Grouped per account, keeping each account's postings in feed order
+    std::vector<size_t> order(postings.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&postings](size_t a, size_t b) {
+        return postings[a].accountIndex < postings[b].accountIndex;
+    });
+
+    std::vector<size_t> touched;
+    std::vector<AccountTally> tallies;
+    for (size_t i : order) {
+        const Posting& posting = postings[i];
+        if (touched.empty() || touched.back() != posting.accountIndex) {
+            touched.push_back(posting.accountIndex);
+            tallies.push_back(AccountTally());
+        }
+        (posting.deposit ? tallies.back().deposits : tallies.back().withdrawals)++;
+    }
+
+    std::vector<std::unique_lock<std::mutex>> locks = lockAccounts(touched);
+
+    for (size_t i = 0; i < touched.size(); ++i) {
+        accounts[touched[i]].reserveTransactions(tallies[i].deposits, tallies[i].withdrawals);
+    }
+    for (size_t i : order) {
+        const Posting& posting = postings[i];
+        if (posting.deposit) {
+            accounts[posting.accountIndex].addDeposit(posting.amount);
+        } else {
+            accounts[posting.accountIndex].addWithdrawal(posting.amount);
+        }
+    }
+
+    if (snapshots) {
+        snapshots->publish(accounts, touched);
+    }
+}
+
+std::vector<std::unique_lock<std::mutex>> TransferEngine::lockAccounts(const std::vector<size_t>& touched) {
+    // Lock stripes in ascending order so concurrent batches can never deadlock
+    std::vector<size_t> stripeIds;
+    stripeIds.reserve(std::min(touched.size(), LOCK_STRIPES));
+    for (size_t account : touched) {
+        stripeIds.push_back(account % LOCK_STRIPES);
+    }
+    std::sort(stripeIds.begin(), stripeIds.end());
+    stripeIds.erase(std::unique(stripeIds.begin(), stripeIds.end()), stripeIds.end());
+
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(stripeIds.size());
+    for (size_t stripe : stripeIds) {
+        locks.push_back(std::unique_lock<std::mutex>(stripes[stripe]));
+    }
+    return locks;
+}
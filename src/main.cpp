@@ -7,34 +7,112 @@
 #include <set>
 #include <map>
 #include <string>
+#include <climits>
+#include <cstdio>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 #include "BankAccount.h"
+#include "TransferEngine.h"
+#include "SnapshotRegistry.h"
+#include "BatchMode.h"
+#include "AccountStorage.h"
+#include "Checksum.h"
+#include "AccountIndex.h"
+#include "AmountKernels.h"
+#include "DataExchange.h"
+#include "ShardedStorage.h"
+#include "IngestPipeline.h"
+#include "AnomalyReport.h"
+#include "MemoryReport.h"
 
 // Function prototypes
 void displayMainMenu();
-void addBankAccount(std::vector<BankAccount>& accounts);
-void addDepositToAccount(std::vector<BankAccount>& accounts);
-void addWithdrawalToAccount(std::vector<BankAccount>& accounts);
+void addBankAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots, AccountIndex& index);
+void addDepositToAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                         const AccountIndex& index);
+void addWithdrawalToAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                            const AccountIndex& index);
 void displayAllAccounts(const std::vector<BankAccount>& accounts);
-void displayAccountDetails(const std::vector<BankAccount>& accounts);
+void displayAccountDetails(const std::vector<BankAccount>& accounts, const AccountIndex& index);
 void createAccountsFile(const std::vector<BankAccount>& accounts);
-void displayOwnersWithMultipleAccounts(const std::vector<BankAccount>& accounts);
-void displayDepositWithdrawalDifferences(const std::vector<BankAccount>& accounts);
+void displayOwnersWithMultipleAccounts(const SnapshotRegistry& snapshots);
+void displayDepositWithdrawalDifferences(const SnapshotRegistry& snapshots);
 void saveEqualAccountsToFile(const std::vector<BankAccount>& accounts);
-void saveDataToFile(const std::vector<BankAccount>& accounts);
-void loadDataFromFile(std::vector<BankAccount>& accounts);
-int selectAccount(const std::vector<BankAccount>& accounts);
+void transferBetweenAccounts(const std::vector<BankAccount>& accounts, const AccountIndex& index,
+                             TransferEngine& transfers);
+void verifyDataFile();
+void importExportData(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                      AccountIndex& index);
+bool printChecksumReport(const std::string& filename, const ChecksumReport& report);
+void saveDataToFile(std::vector<BankAccount>& accounts);
+bool loadShardedData(std::vector<BankAccount>& accounts);
+void printShardReport(const ShardReport& report);
+void configureShards(std::vector<BankAccount>& accounts);
+void ingestTransactionFeed(const AccountIndex& index, TransferEngine& transfers);
+void displayAnomalyReport(const SnapshotRegistry& snapshots);
+void manageMemory(std::vector<BankAccount>& accounts, const AccountIndex& index,
+                  const SnapshotRegistry& snapshots);
+void loadDataFromFile(std::vector<BankAccount>& accounts, bool interactive = true);
+int selectAccount(const std::vector<BankAccount>& accounts, const AccountIndex& index);
 void clearScreen();
 void pauseScreen();
 int getValidatedInt(const std::string& prompt, int min = INT_MIN, int max = INT_MAX);
 double getValidatedDouble(const std::string& prompt, double min = 0.0);
 
-int main() {
+int main(int argc, char* argv[]) {
     std::vector<BankAccount> accounts;
+    SnapshotRegistry snapshots;
+    AccountIndex index;
+    TransferEngine transfers(accounts, &snapshots);
+    
+    // Verify-only mode: bank_system --verify <file>...
+    if (argc >= 3 && std::string(argv[1]) == "--verify") {
+        bool allValid = true;
+        for (int i = 2; i < argc; ++i) {
+            allValid = printChecksumReport(argv[i], verifyChecksums(argv[i])) && allValid;
+        }
+        return allValid ? 0 : 1;
+    }
+    
+    // Conversion mode: bank_system --export <data-file> <accounts|transactions> <output>
+    if (argc == 5 && std::string(argv[1]) == "--export") {
+        try {
+            exportDataFile(argv[2], argv[4], exchangeRecordsFor(argv[3]));
+            std::cout << "[OK] Exported " << argv[3] << " from \"" << argv[2]
+                      << "\" to \"" << argv[4] << "\"" << std::endl;
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Error exporting: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    
+    // Non-interactive mode: bank_system --batch <script> (use "-" for standard input)
+    if (argc == 3 && std::string(argv[1]) == "--batch") {
+        loadDataFromFile(accounts, false);
+        snapshots.publishAll(accounts);
+        index.rebuild(accounts);
+        
+        std::ifstream script;
+        std::string scriptName = argv[2];
+        if (scriptName != "-") {
+            script.open(scriptName);
+            if (!script) {
+                std::cerr << "[ERROR] Cannot open batch script \"" << scriptName << "\"" << std::endl;
+                return 1;
+            }
+        }
+        
+        BatchContext context = { accounts, transfers, snapshots, index };
+        int failures = runBatchMode(scriptName == "-" ? std::cin : script, std::cout, context);
+        saveDataToFile(accounts);
+        return failures == 0 ? 0 : 1;
+    }
     
     loadDataFromFile(accounts);
+    snapshots.publishAll(accounts);
+    index.rebuild(accounts);
     
     int choice;
     bool running = true;
@@ -46,37 +124,58 @@ int main() {
     
     while (running) {
         displayMainMenu();
-        choice = getValidatedInt("Enter choice: ", 0, 9);
+        choice = getValidatedInt("Enter choice: ", 0, 16);
         
         try {
             switch (choice) {
                 case 1:
-                    addBankAccount(accounts);
+                    addBankAccount(accounts, snapshots, index);
                     break;
                 case 2:
-                    addDepositToAccount(accounts);
+                    addDepositToAccount(accounts, snapshots, index);
                     break;
                 case 3:
-                    addWithdrawalToAccount(accounts);
+                    addWithdrawalToAccount(accounts, snapshots, index);
                     break;
                 case 4:
                     displayAllAccounts(accounts);
                     break;
                 case 5:
-                    displayAccountDetails(accounts);
+                    displayAccountDetails(accounts, index);
                     break;
                 case 6:
                     createAccountsFile(accounts);
                     break;
                 case 7:
-                    displayOwnersWithMultipleAccounts(accounts);
+                    displayOwnersWithMultipleAccounts(snapshots);
                     break;
                 case 8:
-                    displayDepositWithdrawalDifferences(accounts);
+                    displayDepositWithdrawalDifferences(snapshots);
                     break;
                 case 9:
                     saveEqualAccountsToFile(accounts);
                     break;
+                case 10:
+                    transferBetweenAccounts(accounts, index, transfers);
+                    break;
+                case 11:
+                    verifyDataFile();
+                    break;
+                case 12:
+                    importExportData(accounts, snapshots, index);
+                    break;
+                case 13:
+                    configureShards(accounts);
+                    break;
+                case 14:
+                    ingestTransactionFeed(index, transfers);
+                    break;
+                case 15:
+                    displayAnomalyReport(snapshots);
+                    break;
+                case 16:
+                    manageMemory(accounts, index, snapshots);
+                    break;
                 case 0:
                     std::cout << "\nSaving data...\n";
                     saveDataToFile(accounts);
@@ -108,11 +207,18 @@ void displayMainMenu() {
     std::cout << "7. Display Owners with Multiple Accounts" << std::endl;
     std::cout << "8. Display Deposit-Withdrawal Differences" << std::endl;
     std::cout << "9. Save Accounts with Equal Deposits and Withdrawals" << std::endl;
+    std::cout << "10. Transfer Between Accounts" << std::endl;
+    std::cout << "11. Verify Data File Checksums" << std::endl;
+    std::cout << "12. Import / Export (CSV, JSON Lines)" << std::endl;
+    std::cout << "13. Sharded Storage" << std::endl;
+    std::cout << "14. Ingest Transaction Feed" << std::endl;
+    std::cout << "15. Anomaly Report" << std::endl;
+    std::cout << "16. Memory Usage and Compaction" << std::endl;
     std::cout << "0. Exit" << std::endl;
     std::cout << std::string(65, '=') << std::endl;
 }
 
-void addBankAccount(std::vector<BankAccount>& accounts) {
+void addBankAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots, AccountIndex& index) {
     clearScreen();
     std::cout << "\n=== ADD BANK ACCOUNT ===\n\n";
     
@@ -120,6 +226,8 @@ void addBankAccount(std::vector<BankAccount>& accounts) {
         BankAccount account;
         std::cin >> account;
         accounts.push_back(account);
+        snapshots.publish(accounts, std::vector<size_t>());
+        index.add(accounts.back(), accounts.size() - 1);
         std::cout << "\n[OK] Account added successfully!\n";
     } catch (const std::exception& e) {
         std::cerr << "[ERROR] Error adding account: " 
@@ -129,7 +237,8 @@ void addBankAccount(std::vector<BankAccount>& accounts) {
     pauseScreen();
 }
 
-void addDepositToAccount(std::vector<BankAccount>& accounts) {
+void addDepositToAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                         const AccountIndex& index) {
     clearScreen();
     
     if (accounts.empty()) {
@@ -140,7 +249,7 @@ void addDepositToAccount(std::vector<BankAccount>& accounts) {
     
     std::cout << "\n=== ADD DEPOSIT ===\n\n";
     
-    int accountIndex = selectAccount(accounts);
+    int accountIndex = selectAccount(accounts, index);
     if (accountIndex == -1) {
         return;
     }
@@ -148,6 +257,7 @@ void addDepositToAccount(std::vector<BankAccount>& accounts) {
     try {
         double amount = getValidatedDouble("Enter deposit amount: ");
         accounts[accountIndex].addDeposit(amount);
+        snapshots.publish(accounts, std::vector<size_t>(1, accountIndex));
         std::cout << "\n[OK] Deposit added successfully!\n";
     } catch (const std::exception& e) {
         std::cerr << "[ERROR] Error adding deposit: " 
@@ -157,7 +267,8 @@ void addDepositToAccount(std::vector<BankAccount>& accounts) {
     pauseScreen();
 }
 
-void addWithdrawalToAccount(std::vector<BankAccount>& accounts) {
+void addWithdrawalToAccount(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                            const AccountIndex& index) {
     clearScreen();
     
     if (accounts.empty()) {
@@ -168,7 +279,7 @@ void addWithdrawalToAccount(std::vector<BankAccount>& accounts) {
     
     std::cout << "\n=== ADD WITHDRAWAL ===\n\n";
     
-    int accountIndex = selectAccount(accounts);
+    int accountIndex = selectAccount(accounts, index);
     if (accountIndex == -1) {
         return;
     }
@@ -176,6 +287,7 @@ void addWithdrawalToAccount(std::vector<BankAccount>& accounts) {
     try {
         double amount = getValidatedDouble("Enter withdrawal amount: ");
         accounts[accountIndex].addWithdrawal(amount);
+        snapshots.publish(accounts, std::vector<size_t>(1, accountIndex));
         std::cout << "\n[OK] Withdrawal added successfully!\n";
     } catch (const std::exception& e) {
         std::cerr << "[ERROR] Error adding withdrawal: " 
@@ -204,7 +316,7 @@ void displayAllAccounts(const std::vector<BankAccount>& accounts) {
     pauseScreen();
 }
 
-void displayAccountDetails(const std::vector<BankAccount>& accounts) {
+void displayAccountDetails(const std::vector<BankAccount>& accounts, const AccountIndex& index) {
     clearScreen();
     
     if (accounts.empty()) {
@@ -213,7 +325,7 @@ void displayAccountDetails(const std::vector<BankAccount>& accounts) {
         return;
     }
     
-    int accountIndex = selectAccount(accounts);
+    int accountIndex = selectAccount(accounts, index);
     if (accountIndex == -1) {
         return;
     }
@@ -221,6 +333,20 @@ void displayAccountDetails(const std::vector<BankAccount>& accounts) {
     std::cout << "\n=== ACCOUNT DETAILS ===\n\n";
     std::cout << accounts[accountIndex];
     
+    const TransactionStats* series[] = { &accounts[accountIndex].getDepositStats(),
+                                         &accounts[accountIndex].getWithdrawalStats() };
+    const char* names[] = { "Deposits", "Withdrawals" };
+    std::cout << "\n" << std::left << std::setw(13) << "Statistics" << std::right << std::setw(7) << "Count"
+              << std::setw(13) << "Mean" << std::setw(13) << "Std dev" << std::setw(13) << "Min"
+              << std::setw(13) << "Max" << std::setw(7) << "Large" << "\n";
+    for (int i = 0; i < 2; ++i) {
+        const TransactionStats& stats = *series[i];
+        std::cout << std::left << std::setw(13) << names[i] << std::right << std::setw(7) << stats.count
+                  << std::fixed << std::setprecision(2) << std::setw(13) << stats.mean
+                  << std::setw(13) << stats.stddev() << std::setw(13) << stats.min
+                  << std::setw(13) << stats.max << std::setw(7) << stats.largeCount << "\n";
+    }
+    
     pauseScreen();
 }
 
@@ -246,16 +372,7 @@ void createAccountsFile(const std::vector<BankAccount>& accounts) {
     }
     
     try {
-        std::ofstream file(filename);
-        if (!file) {
-            throw std::runtime_error("Cannot create file");
-        }
-        
-        file << accounts.size() << "\n";
-        for (const auto& account : accounts) {
-            account.saveToFile(file);
-        }
-        file.close();
+        saveAccountsFile(filename, accounts);
         
         std::cout << "\n[OK] File \"" << filename << "\" created successfully!\n";
         std::cout << "  Accounts count: " << accounts.size() << "\n";
@@ -267,10 +384,12 @@ void createAccountsFile(const std::vector<BankAccount>& accounts) {
     pauseScreen();
 }
 
-void displayOwnersWithMultipleAccounts(const std::vector<BankAccount>& accounts) {
+void displayOwnersWithMultipleAccounts(const SnapshotRegistry& snapshots) {
     clearScreen();
     
-    if (accounts.empty()) {
+    std::shared_ptr<const BookSnapshot> accounts = snapshots.acquire();
+    
+    if (accounts->empty()) {
         std::cout << "\n[ERROR] No accounts available!\n";
         pauseScreen();
         return;
@@ -280,9 +399,8 @@ void displayOwnersWithMultipleAccounts(const std::vector<BankAccount>& accounts)
     
     // Count accounts per owner
     std::map<std::string, int> ownerCount;
-    for (const auto& account : accounts) {
-        std::string ownerName = account.getOwnerName();
-        ownerCount[ownerName]++;
+    for (size_t i = 0; i < accounts->size(); ++i) {
+        ownerCount[(*accounts)[i].getOwnerName()]++;
     }
     
     // Collect owners with more than one account
@@ -309,10 +427,13 @@ void displayOwnersWithMultipleAccounts(const std::vector<BankAccount>& accounts)
     pauseScreen();
 }
 
-void displayDepositWithdrawalDifferences(const std::vector<BankAccount>& accounts) {
+void displayDepositWithdrawalDifferences(const SnapshotRegistry& snapshots) {
     clearScreen();
     
-    if (accounts.empty()) {
+    // Work from one published version so concurrent postings cannot tear the report
+    std::shared_ptr<const BookSnapshot> accounts = snapshots.acquire();
+    
+    if (accounts->empty()) {
         std::cout << "\n[ERROR] No accounts available!\n";
         pauseScreen();
         return;
@@ -327,9 +448,10 @@ void displayDepositWithdrawalDifferences(const std::vector<BankAccount>& account
               << std::setw(15) << "Difference" << std::endl;
     std::cout << std::string(95, '-') << std::endl;
     
-    for (const auto& account : accounts) {
-        double totalDeposited = account.getTotalDeposited();
-        double totalWithdrawn = account.getTotalWithdrawn();
+    for (size_t i = 0; i < accounts->size(); ++i) {
+        const AccountSnapshot& account = (*accounts)[i];
+        double totalDeposited = account.totalDeposited;
+        double totalWithdrawn = account.totalWithdrawn;
         double difference = account.getBalance();
         
         std::cout << std::left << std::setw(15) << account.getUniqueCode()
@@ -340,6 +462,21 @@ void displayDepositWithdrawalDifferences(const std::vector<BankAccount>& account
                   << std::setw(15) << difference << std::endl;
     }
     
+    // Book-wide figures come from the bulk kernels over the snapshot's totals
+    std::vector<double> deposited, withdrawn;
+    accounts->collectTotals(deposited, withdrawn);
+    double bookDeposited = sumAmounts(deposited.data(), deposited.size());
+    double bookWithdrawn = sumAmounts(withdrawn.data(), withdrawn.size());
+    
+    std::cout << std::string(95, '-') << std::endl;
+    std::cout << std::left << std::setw(40) << "Total"
+              << std::fixed << std::setprecision(2)
+              << std::setw(20) << bookDeposited
+              << std::setw(20) << bookWithdrawn
+              << std::setw(15) << bookDeposited - bookWithdrawn << std::endl;
+    std::cout << "Accounts with equal deposits and withdrawals: "
+              << countEqual(deposited.data(), withdrawn.data(), deposited.size()) << std::endl;
+    
     pauseScreen();
 }
 
@@ -371,16 +508,7 @@ void saveEqualAccountsToFile(const std::vector<BankAccount>& accounts) {
     std::string filename = "equal_accounts.dat";
     
     try {
-        std::ofstream file(filename);
-        if (!file) {
-            throw std::runtime_error("Cannot create file");
-        }
-        
-        file << equalAccounts.size() << "\n";
-        for (const auto& account : equalAccounts) {
-            account.saveToFile(file);
-        }
-        file.close();
+        saveAccountsFile(filename, equalAccounts);
         
         std::cout << "[OK] File \"" << filename << "\" created successfully!\n";
         std::cout << "  Accounts count: " << equalAccounts.size() << "\n\n";
@@ -398,18 +526,307 @@ void saveEqualAccountsToFile(const std::vector<BankAccount>& accounts) {
     pauseScreen();
 }
 
-void saveDataToFile(const std::vector<BankAccount>& accounts) {
+void transferBetweenAccounts(const std::vector<BankAccount>& accounts, const AccountIndex& index,
+                             TransferEngine& transfers) {
+    clearScreen();
+    
+    if (accounts.size() < 2) {
+        std::cout << "\n[ERROR] At least two accounts are needed for a transfer!\n";
+        pauseScreen();
+        return;
+    }
+    
+    std::cout << "\n=== TRANSFER BETWEEN ACCOUNTS ===\n\n";
+    
+    std::cout << "Source account:";
+    int fromIndex = selectAccount(accounts, index);
+    if (fromIndex == -1) {
+        return;
+    }
+    std::cout << "\nDestination account:";
+    int toIndex = selectAccount(accounts, index);
+    if (toIndex == -1) {
+        return;
+    }
+    
     try {
-        std::ofstream file("bank_accounts.dat");
-        if (!file) {
-            throw std::runtime_error("Cannot open file");
-        }
+        Transfer transfer;
+        transfer.fromIndex = static_cast<size_t>(fromIndex);
+        transfer.toIndex = static_cast<size_t>(toIndex);
+        transfer.amount = getValidatedDouble("Enter transfer amount: ");
         
-        file << accounts.size() << "\n";
-        for (const auto& account : accounts) {
-            account.saveToFile(file);
+        transfers.applyBatch(std::vector<Transfer>(1, transfer));
+        std::cout << "\n[OK] Transfer completed successfully!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Error transferring: " 
+                  << e.what() << std::endl;
+    }
+    
+    pauseScreen();
+}
+
+void verifyDataFile() {
+    clearScreen();
+    std::cout << "\n=== VERIFY DATA FILE CHECKSUMS ===\n\n";
+    
+    std::string filename;
+    std::cout << "Enter filename (empty for bank_accounts.dat): ";
+    std::cout.flush();
+    std::getline(std::cin, filename);
+    
+    if (filename.empty()) {
+        filename = "bank_accounts.dat";
+    }
+    
+    printChecksumReport(filename, verifyChecksums(filename));
+    pauseScreen();
+}
+
+void importExportData(std::vector<BankAccount>& accounts, SnapshotRegistry& snapshots,
+                      AccountIndex& index) {
+    clearScreen();
+    std::cout << "\n=== IMPORT / EXPORT ===\n\n";
+    std::cout << "1. Export accounts\n";
+    std::cout << "2. Export transactions\n";
+    std::cout << "3. Import accounts\n";
+    std::cout << "4. Import transactions\n";
+    std::cout << "0. Back\n";
+    
+    int choice = getValidatedInt("Enter choice: ", 0, 4);
+    if (choice == 0) {
+        return;
+    }
+    
+    std::string filename;
+    std::cout << "Enter filename (.csv or .jsonl): ";
+    std::cout.flush();
+    std::getline(std::cin, filename);
+    
+    ExchangeRecords records = (choice == 1 || choice == 3) ? ExchangeRecords::Accounts
+                                                           : ExchangeRecords::Transactions;
+    try {
+        if (choice <= 2) {
+            exportAccounts(accounts, filename, records);
+            std::cout << "\n[OK] Exported " << accounts.size() << " accounts to \""
+                      << filename << "\"\n";
+        } else {
+            ImportResult result = importRecords(filename, records, accounts, index);
+            snapshots.publishAll(accounts);
+            
+            std::cout << "\n[OK] Imported " << result.imported << " records, rejected "
+                      << result.rejected << "\n";
+            for (const auto& error : result.errors) {
+                std::cout << "  " << error << "\n";
+            }
         }
-        file.close();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Error: " << e.what() << std::endl;
+    }
+    
+    pauseScreen();
+}
+
+void configureShards(std::vector<BankAccount>& accounts) {
+    clearScreen();
+    std::cout << "\n=== SHARDED STORAGE ===\n\n";
+    
+    size_t current = readShardCount("bank_accounts.manifest");
+    if (current == 0) {
+        std::cout << "Current layout: single file (bank_accounts.dat)\n";
+    } else {
+        std::cout << "Current layout: " << current << " shards (bank_accounts.manifest)\n";
+    }
+    
+    std::vector<std::string> missing = current == 0 ? std::vector<std::string>()
+                                                    : missingShards("bank_accounts.manifest");
+    if (!missing.empty()) {
+        std::cout << "[WARNING] " << missing.size() << " shards are missing; saving now drops their accounts\n";
+    }
+    
+    int shardCount = getValidatedInt("Enter number of shards (0 = single file): ", 0,
+                                     static_cast<int>(MAX_SHARDS));
+    
+    if (shardCount == 0) {
+        saveAccountsFile("bank_accounts.dat", accounts);
+        removeShards("bank_accounts.manifest");
+        std::cout << "\n[OK] Saved " << accounts.size() << " accounts to bank_accounts.dat\n";
+        pauseScreen();
+        return;
+    }
+    
+    ShardReport report = saveShards("bank_accounts.manifest", accounts, static_cast<size_t>(shardCount));
+    
+    std::cout << "\n" << std::left << std::setw(36) << "Shard" << std::right << std::setw(10)
+              << "Accounts" << std::setw(12) << "Bytes" << "  Status\n";
+    std::cout << std::string(65, '-') << "\n";
+    for (const auto& shard : report.shards) {
+        std::cout << std::left << std::setw(36) << shard.filename << std::right << std::setw(10)
+                  << shard.accounts << std::setw(12) << shard.bytes << "  "
+                  << (!shard.error.empty() ? "FAILED" : shard.written ? "written" : "unchanged") << "\n";
+    }
+    printShardReport(report);
+    
+    if (report.failedCount() == 0) {
+        std::cout << "\n[OK] " << report.writtenCount() << " of " << shardCount << " shards written\n";
+    }
+    pauseScreen();
+}
+
+void ingestTransactionFeed(const AccountIndex& index, TransferEngine& transfers) {
+    clearScreen();
+    std::cout << "\n=== INGEST TRANSACTION FEED ===\n\n";
+    
+    std::string feed;
+    std::cout << "Enter feed filename (.csv or .jsonl, rows: code,type,amount): ";
+    std::cout.flush();
+    std::getline(std::cin, feed);
+    
+    try {
+        IngestReport report = ingestTransactions(feed, index, transfers);
+        std::cout << "\n";
+        printIngestReport(report, std::cout);
+        if (!report.error.empty()) {
+            std::cerr << "[ERROR] Ingestion stopped early: " << report.error << std::endl;
+        } else {
+            std::cout << "\n[OK] Feed ingested\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Error ingesting: " << e.what() << std::endl;
+    }
+    
+    pauseScreen();
+}
+
+void displayAnomalyReport(const SnapshotRegistry& snapshots) {
+    clearScreen();
+    std::cout << "\n=== ANOMALY REPORT ===\n\n";
+    std::cout << "Lists accounts whose latest deposit or withdrawal is far from their earlier ones.\n";
+    
+    double threshold = getValidatedDouble("Enter threshold in standard deviations (e.g. 3): ", 0.0);
+    
+    std::shared_ptr<const BookSnapshot> snapshot = snapshots.acquire();
+    std::vector<Anomaly> anomalies = findAnomalies(*snapshot, threshold);
+    
+    std::cout << "\n";
+    printAnomalies(*snapshot, anomalies, 50, std::cout);
+    pauseScreen();
+}
+
+void manageMemory(std::vector<BankAccount>& accounts, const AccountIndex& index,
+                  const SnapshotRegistry& snapshots) {
+    clearScreen();
+    std::cout << "\n=== MEMORY USAGE ===\n\n";
+    
+    printMemoryReport(measureMemory(accounts, index, *snapshots.acquire()), std::cout);
+    
+    std::cout << "\n1. Compact (trim dormant accounts, keep headroom for active ones)\n";
+    std::cout << "0. Back\n";
+    if (getValidatedInt("Enter choice: ", 0, 1) == 1) {
+        std::cout << "\n";
+        printCompactionResult(compactAccounts(accounts), std::cout);
+    }
+    
+    pauseScreen();
+}
+
+bool printChecksumReport(const std::string& filename, const ChecksumReport& report) {
+    if (!report.hasChecksums) {
+        std::cout << "[ERROR] \"" << filename << "\": "
+                  << (report.error.empty() ? "no checksums found" : report.error) << "\n";
+        return false;
+    }
+    if (!report.error.empty()) {
+        std::cout << "[ERROR] \"" << filename << "\": " << report.error << "\n";
+        return false;
+    }
+    if (!report.valid) {
+        std::cout << "[ERROR] \"" << filename << "\": " << report.badBlocks << " of "
+                  << report.blockCount << " blocks corrupted, first is block "
+                  << report.firstBadBlock << "\n";
+        return false;
+    }
+    
+    std::cout << "[OK] \"" << filename << "\": " << report.blockCount << " blocks, "
+              << report.payloadLength << " bytes verified (" << crc32cImplementation() << ")\n";
+    return true;
+}
+
+void printShardReport(const ShardReport& report) {
+    for (const auto& shard : report.shards) {
+        if (!shard.error.empty()) {
+            std::cerr << "  [ERROR] " << shard.filename << ": " << shard.error << std::endl;
+        } else if (!shard.warning.empty()) {
+            std::cout << "  [WARNING] " << shard.filename << ": " << shard.warning << "\n";
+        }
+    }
+}
+
+bool loadShardedData(std::vector<BankAccount>& accounts) {
+    ShardReport report;
+    try {
+        if (!loadShards("bank_accounts.manifest", accounts, report)) {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        // The book is sharded, so bank_accounts.dat is never a valid fallback
+        std::cerr << "[ERROR] Error loading: " << e.what() << std::endl;
+        if (!recoverShards("bank_accounts.manifest", accounts, report)) {
+            printShardReport(report);
+            std::cerr << "  The shard files do not form one complete layout, so nothing was loaded.\n"
+                      << "  Saving stays disabled until bank_accounts.manifest is repaired." << std::endl;
+            accounts.clear();
+            return true;
+        }
+        std::cout << "  [WARNING] Manifest rebuilt from the shard files; the damaged one was moved to "
+                  << "bank_accounts.manifest.corrupt\n";
+    }
+    
+    std::cout << "\n[OK] Loaded " << report.shards.size() - report.failedCount() << " of "
+              << report.shards.size() << " shards\n";
+    printShardReport(report);
+    
+    // Same policy as a damaged bank_accounts.dat: keep bad shards out of the way of the next save
+    for (const auto& shard : report.shards) {
+        if (!shard.error.empty()) {
+            const std::string aside = shard.filename + ".corrupt";
+            std::remove(aside.c_str());
+            if (std::rename(shard.filename.c_str(), aside.c_str()) == 0) {
+                std::cerr << "  " << shard.filename << " was moved to " << aside << std::endl;
+            }
+        }
+    }
+    if (report.failedCount() > 0) {
+        std::cerr << "  Saving is disabled until the missing shards are restored, or the layout is\n"
+                  << "  saved again (option 13 or save-shards), which drops their accounts." << std::endl;
+    }
+    return true;
+}
+
+void saveDataToFile(std::vector<BankAccount>& accounts) {
+    try {
+        size_t shardCount = readShardCount("bank_accounts.manifest");
+        if (shardCount > 0) {
+            std::vector<std::string> missing = missingShards("bank_accounts.manifest");
+            if (!missing.empty()) {
+                std::cerr << "[ERROR] Not saved: " << missing.size() << " shards are missing (" << missing[0]
+                          << (missing.size() > 1 ? ", ..." : "") << ").\n"
+                          << "  Restore them, or save the layout again (option 13 or save-shards) to drop their accounts."
+                          << std::endl;
+                return;
+            }
+            ShardReport shards = saveShards("bank_accounts.manifest", accounts, shardCount);
+            printShardReport(shards);
+            if (shards.failedCount() > 0) {
+                std::cerr << "[ERROR] " << shards.failedCount() << " shards were not saved" << std::endl;
+                return;
+            }
+            std::cout << "\n[OK] Data saved successfully! (" << shards.writtenCount() << " of "
+                      << shardCount << " shards changed)\n";
+            std::cout << "  Accounts count: " << accounts.size() << "\n";
+            return;
+        }
+        
+        saveAccountsFile("bank_accounts.dat", accounts);
         
         std::cout << "\n[OK] Data saved successfully!\n";
         std::cout << "  Accounts count: " << accounts.size() << "\n";
@@ -418,45 +835,89 @@ void saveDataToFile(const std::vector<BankAccount>& accounts) {
     }
 }
 
-void loadDataFromFile(std::vector<BankAccount>& accounts) {
+void loadDataFromFile(std::vector<BankAccount>& accounts, bool interactive) {
     try {
-        std::ifstream file("bank_accounts.dat");
-        if (file) {
-            size_t accountCount;
-            file >> accountCount;
-            file.ignore();
-            
-            accounts.clear();
-            for (size_t i = 0; i < accountCount; ++i) {
-                BankAccount account;
-                account.loadFromFile(file);
-                accounts.push_back(account);
+        if (loadShardedData(accounts)) {
+            std::cout << "  Accounts count: " << accounts.size() << "\n";
+            if (interactive) {
+                pauseScreen();
             }
-            file.close();
-            
+            return;
+        }
+        
+        ChecksumReport verification;
+        if (loadAccountsFile("bank_accounts.dat", accounts, &verification)) {
             std::cout << "\n[OK] Data loaded successfully!\n";
+            if (!verification.hasChecksums) {
+                std::cout << "  [WARNING] File has no checksums; they are added on the next save\n";
+            }
             std::cout << "  Accounts count: " << accounts.size() << "\n";
-            pauseScreen();
+            if (interactive) {
+                pauseScreen();
+            }
         }
     } catch (const std::exception& e) {
         std::cerr << "[ERROR] Error loading: " << e.what() << std::endl;
+        
+        // Keep the damaged file out of the way so the next save cannot overwrite it
+        std::remove("bank_accounts.dat.corrupt");
+        if (std::rename("bank_accounts.dat", "bank_accounts.dat.corrupt") == 0) {
+            std::cerr << "  The file was moved to bank_accounts.dat.corrupt" << std::endl;
+        }
+        accounts.clear();
     }
 }
 
-int selectAccount(const std::vector<BankAccount>& accounts) {
-    std::cout << "\nAvailable accounts:\n";
-    std::cout << std::string(65, '-') << std::endl;
+int selectAccount(const std::vector<BankAccount>& accounts, const AccountIndex& index) {
+    const size_t pageSize = 10;
+    std::string prefix;
+    size_t page = 0;
     
-    for (size_t i = 0; i < accounts.size(); ++i) {
-        std::cout << "[" << (i + 1) << "] " << accounts[i].getUniqueCode() 
-                  << " - " << accounts[i].getOwnerName() << std::endl;
+    while (true) {
+        // Code matches first, then owner matches; an empty prefix lists every account by code
+        PrefixMatches matches = prefix.empty()
+            ? index.findByCode(prefix, page * pageSize, pageSize)
+            : index.findByCodeOrOwner(accounts, prefix, page * pageSize, pageSize);
+        const std::vector<size_t>& shown = matches.accounts;
+        size_t total = matches.total;
+        size_t pages = total == 0 ? 1 : (total + pageSize - 1) / pageSize;
+        
+        std::cout << "\nAccounts";
+        if (!prefix.empty()) {
+            std::cout << " matching \"" << prefix << "\"";
+        }
+        std::cout << ": " << total << " (page " << (page + 1) << " of " << pages << ")\n";
+        std::cout << std::string(65, '-') << std::endl;
+        for (size_t i = 0; i < shown.size(); ++i) {
+            std::cout << "[" << (i + 1) << "] " << accounts[shown[i]].getUniqueCode() 
+                      << " - " << accounts[shown[i]].getOwnerName() << std::endl;
+        }
+        std::cout << std::string(65, '-') << std::endl;
+        
+        std::cout << "Select number, type a code or owner prefix to search,\n"
+                  << "'n'/'p' for next/previous page, 'q' to cancel: ";
+        std::cout.flush();
+        std::string input;
+        if (!std::getline(std::cin, input) || input == "q") {
+            return -1;
+        }
+        
+        if (input == "n") {
+            if (page + 1 < pages) ++page;
+        } else if (input == "p") {
+            if (page > 0) --page;
+        } else if (!input.empty() && input.size() < 10 &&
+                   input.find_first_not_of("0123456789") == std::string::npos) {
+            size_t choice = std::stoul(input);
+            if (choice >= 1 && choice <= shown.size()) {
+                return static_cast<int>(shown[choice - 1]);
+            }
+            std::cout << "[ERROR] Number must be between 1 and " << shown.size() << ".\n";
+        } else {
+            prefix = input;
+            page = 0;
+        }
     }
-    
-    std::cout << std::string(65, '-') << std::endl;
-    int choice = getValidatedInt("Select account: ", 1, 
-                                  static_cast<int>(accounts.size()));
-    
-    return choice - 1;
 }
 
 void clearScreen() {
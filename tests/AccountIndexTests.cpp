@@ -0,0 +1,69 @@
+#include "TestFramework.h"
+#include <algorithm>
+#include "AccountIndex.h"
+
+namespace {
+
+std::vector<BankAccount> sampleAccounts() {
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Anna Petrova"));
+    accounts.push_back(BankAccount("B00002", "Anton Ivanov"));
+    accounts.push_back(BankAccount("A00003", "Boris Georgiev"));
+    accounts.push_back(BankAccount("C00004", "anelia Dimitrova"));
+    accounts.push_back(BankAccount("A00005", "Asen Kolev"));
+    return accounts;
+}
+
+}
+
+TEST(prefixSearchIsCaseInsensitive) {
+    std::vector<BankAccount> accounts = sampleAccounts();
+    AccountIndex index;
+    index.rebuild(accounts);
+
+    PrefixMatches owners = index.findByOwner("AN", 0, 10);
+    CHECK(owners.total == 3);
+    CHECK(owners.accounts.size() == 3);
+
+    size_t position = 0;
+    CHECK(index.findCode("a00003", position));
+    CHECK(position == 2);
+    CHECK(!index.findCode("A0000", position));
+}
+
+TEST(codeOrOwnerMatchesListEachAccountOnce) {
+    std::vector<BankAccount> accounts = sampleAccounts();
+    AccountIndex index;
+    index.rebuild(accounts);
+
+    // "a" matches codes A00001, A00003, A00005 and owners Anna, Anton, anelia, Asen
+    PrefixMatches all = index.findByCodeOrOwner(accounts, "a", 0, 10);
+    CHECK(all.total == 5);
+    CHECK(all.accounts.size() == 5);
+    std::vector<size_t> sorted = all.accounts;
+    std::sort(sorted.begin(), sorted.end());
+    CHECK(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+
+    // Pages split the same list without gaps or repeats
+    std::vector<size_t> paged;
+    for (size_t offset = 0; offset < all.total; offset += 2) {
+        PrefixMatches page = index.findByCodeOrOwner(accounts, "a", offset, 2);
+        CHECK(page.total == all.total);
+        paged.insert(paged.end(), page.accounts.begin(), page.accounts.end());
+    }
+    CHECK(paged == all.accounts);
+}
+
+TEST(addedAccountsAreFound) {
+    std::vector<BankAccount> accounts = sampleAccounts();
+    AccountIndex index;
+    index.rebuild(accounts);
+
+    accounts.push_back(BankAccount("D00006", "Anna Petrova"));
+    index.add(accounts.back(), accounts.size() - 1);
+
+    CHECK(index.size() == accounts.size());
+    PrefixMatches owners = index.findByOwner("anna", 0, 10);
+    CHECK(owners.total == 2);
+    CHECK(owners.accounts.size() == 2 && owners.accounts[1] == 5); // Equal keys stay in account order
+}
@@ -0,0 +1,51 @@
+#include "TestFramework.h"
+#include "BankAccount.h"
+#include "AmountKernels.h"
+
+TEST(accountTotalsFollowAppendOrder) {
+    // 0.1 + 0.2 + 0.3 in that order differs from other groupings in the last bit
+    const double amounts[] = { 0.1, 0.2, 0.3, 1e16, 0.7, 1.1, 2.2, 3.3 };
+    BankAccount account("A00001", "Ivan Petrov");
+    double expected = 0.0;
+    for (double amount : amounts) {
+        account.addDeposit(amount);
+        expected += amount;
+    }
+    CHECK(account.getTotalDeposited() == expected);
+
+    BankAccount copy(account);
+    BankAccount moved(std::move(copy));
+    CHECK(moved.getTotalDeposited() == expected);
+}
+
+TEST(equalDepositsAndWithdrawalsUseExactTotals) {
+    BankAccount account("A00001", "Ivan Petrov");
+    account.addDeposit(0.1);
+    account.addDeposit(0.2);
+    account.addWithdrawal(0.3);
+    CHECK(!account.hasEqualDepositsAndWithdrawals()); // 0.1 + 0.2 != 0.3 in binary
+    account.addWithdrawal(0.1 + 0.2 - 0.3);
+    CHECK(account.hasEqualDepositsAndWithdrawals());
+}
+
+TEST(vectorKernelsMatchScalar) {
+    std::string failure;
+    CHECK(verifyAmountKernels(failure));
+}
+
+TEST(movedFromAccountStaysUsable) {
+    BankAccount account("A00001", "Ivan Petrov");
+    account.addDeposit(50.0);
+    BankAccount moved(std::move(account));
+
+    CHECK(std::string(account.getUniqueCode()).empty());
+    CHECK(std::string(account.getOwnerName()).empty());
+    CHECK(account.getDepositedCount() == 0);
+    CHECK(account.getBalance() == 0.0);
+
+    BankAccount copy(account);
+    CHECK(std::string(copy.getUniqueCode()).empty());
+    account = moved;
+    CHECK(std::string(account.getUniqueCode()) == "A00001");
+    CHECK(account.getBalance() == 50.0);
+}
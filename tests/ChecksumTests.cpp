@@ -0,0 +1,138 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include "AccountStorage.h"
+
+namespace {
+
+std::string readAll(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void writeAll(const std::string& filename, const std::string& content) {
+    std::ofstream file(filename, std::ios::binary);
+    file << content;
+}
+
+std::vector<BankAccount> sampleAccounts() {
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    accounts.push_back(BankAccount("A00002", "Maria Ivanova"));
+    accounts[0].addDeposit(120.5);
+    accounts[0].addWithdrawal(20.25);
+    accounts[1].addDeposit(75.0);
+    return accounts;
+}
+
+// Saves the sample accounts and returns the file's content
+std::string saveSample(const std::string& filename) {
+    saveAccountsFile(filename, sampleAccounts());
+    return readAll(filename);
+}
+
+bool loadFails(const std::string& filename) {
+    std::vector<BankAccount> accounts;
+    try {
+        loadAccountsFile(filename, accounts);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+}
+
+TEST(savedFileVerifiesWhileLoading) {
+    const std::string filename = testFile("checksum_ok.dat");
+    saveSample(filename);
+
+    std::vector<BankAccount> accounts;
+    ChecksumReport report;
+    CHECK(loadAccountsFile(filename, accounts, &report));
+    CHECK(report.hasChecksums && report.valid && report.blockCount == 1);
+    CHECK(accounts.size() == 2 && accounts[0].getBalance() == 100.25);
+    CHECK(verifyChecksums(filename).valid);
+    std::remove(filename.c_str());
+}
+
+TEST(flippedPayloadByteIsDetected) {
+    const std::string filename = testFile("checksum_flip.dat");
+    std::string content = saveSample(filename);
+    content[content.find("75")] = '9'; // Still parses, but the block CRC no longer matches
+    writeAll(filename, content);
+
+    ChecksumReport report = verifyChecksums(filename);
+    CHECK(report.hasChecksums && !report.valid && report.badBlocks == 1);
+    CHECK(loadFails(filename));
+    std::remove(filename.c_str());
+}
+
+TEST(damagedOrTruncatedTrailerIsNotLegacy) {
+    const std::string filename = testFile("checksum_trailer.dat");
+    const std::string content = saveSample(filename);
+    const size_t footer = content.rfind("#CRC32C ");
+
+    // Footer line cut off, leaving the block list
+    writeAll(filename, content.substr(0, footer));
+    CHECK(verifyChecksums(filename).hasChecksums);
+    CHECK(!verifyChecksums(filename).valid);
+    CHECK(loadFails(filename));
+
+    // Footer magic garbled
+    std::string garbled = content;
+    garbled[footer + 4] = 'X';
+    writeAll(filename, garbled);
+    CHECK(verifyChecksums(filename).hasChecksums);
+    CHECK(loadFails(filename));
+
+    // Only the block CRC lines left after the accounts
+    const size_t blocks = content.find("#CRC32C-BLOCKS");
+    std::string crcLines = content.substr(0, blocks) +
+                           content.substr(content.find('\n', blocks) + 1, footer - content.find('\n', blocks) - 1);
+    writeAll(filename, crcLines);
+    CHECK(loadFails(filename));
+    std::remove(filename.c_str());
+}
+
+TEST(fileWithoutTrailerLoadsAsLegacy) {
+    const std::string filename = testFile("checksum_legacy.dat");
+    const std::string content = saveSample(filename);
+    writeAll(filename, content.substr(0, content.find("#CRC32C-BLOCKS")));
+
+    std::vector<BankAccount> accounts;
+    ChecksumReport report;
+    CHECK(loadAccountsFile(filename, accounts, &report));
+    CHECK(!report.hasChecksums && accounts.size() == 2);
+    std::remove(filename.c_str());
+}
+
+TEST(blockVerifierAcceptsAnyPieceSizes) {
+    std::string payload(2500, 'x');
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+    ChecksumTrailer trailer;
+    trailer.payloadLength = payload.size();
+    trailer.blockSize = 1000;
+    for (size_t start = 0; start < payload.size(); start += trailer.blockSize) {
+        trailer.blockCrcs.push_back(crc32c(payload.data() + start,
+                                           std::min(trailer.blockSize, payload.size() - start)));
+    }
+
+    BlockVerifier verifier(trailer);
+    for (size_t start = 0; start < payload.size(); start += 7) {
+        verifier.update(payload.data() + start, std::min<size_t>(7, payload.size() - start));
+    }
+    ChecksumReport report;
+    verifier.finish(report);
+    CHECK(report.valid);
+
+    BlockVerifier shortRead(trailer);
+    shortRead.update(payload.data(), 1500);
+    shortRead.finish(report);
+    CHECK(!report.valid && report.badBlocks == 2 && report.firstBadBlock == 1);
+}
@@ -0,0 +1,139 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "AccountStorage.h"
+#include "DatReader.h"
+
+namespace {
+
+bool sameAccount(const BankAccount& a, const BankAccount& b) {
+    if (std::strcmp(a.getUniqueCode(), b.getUniqueCode()) != 0 ||
+        std::strcmp(a.getOwnerName(), b.getOwnerName()) != 0 ||
+        a.getDepositedCount() != b.getDepositedCount() ||
+        a.getWithdrawnCount() != b.getWithdrawnCount()) {
+        return false;
+    }
+    for (int i = 0; i < a.getDepositedCount(); ++i) {
+        if (a.getDepositedAmount(i) != b.getDepositedAmount(i)) return false;
+    }
+    for (int i = 0; i < a.getWithdrawnCount(); ++i) {
+        if (a.getWithdrawnAmount(i) != b.getWithdrawnAmount(i)) return false;
+    }
+    return true;
+}
+
+bool sameBook(const std::vector<BankAccount>& a, const std::vector<BankAccount>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!sameAccount(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+// A book whose amounts cover both the fast path and the strtod fallback
+std::vector<BankAccount> generatedBook(int accountCount, int amountsPerAccount) {
+    const double unusual[] = { 1e23, 1.2345678901234567e30, 4.9e-300, 0.1, 123456789012.25 };
+    std::vector<BankAccount> accounts;
+    accounts.reserve(static_cast<size_t>(accountCount));
+    std::srand(7);
+    for (int i = 0; i < accountCount; ++i) {
+        char code[8];
+        std::snprintf(code, sizeof(code), "B%05d", i % 100000);
+        accounts.push_back(BankAccount(code, i % 3 == 0 ? "Ivan Petrov" : "Maria Ivanova"));
+        for (int j = 0; j < amountsPerAccount; ++j) {
+            double amount = (j % 17 == 0) ? unusual[(i + j) % 5]
+                                          : static_cast<double>(std::rand() % 10000000) / 100.0;
+            if (j % 2 == 0) {
+                accounts.back().addDeposit(amount);
+            } else {
+                accounts.back().addWithdrawal(amount);
+            }
+        }
+    }
+    return accounts;
+}
+
+double secondsToParse(void (*parse)(const std::string&, std::vector<BankAccount>&),
+                      const std::string& filename, std::vector<BankAccount>& accounts) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    parse(filename, accounts);
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Reference parser going through BankAccount::loadFromFile one field at a time
+void parseWithStream(const std::string& filename, std::vector<BankAccount>& accounts) {
+    std::ifstream file(filename, std::ios::binary);
+    size_t accountCount;
+    if (!(file >> accountCount)) {
+        throw std::runtime_error("Missing account count");
+    }
+    file.ignore();
+
+    accounts.clear();
+    for (size_t i = 0; i < accountCount; ++i) {
+        accounts.emplace_back();
+        accounts.back().loadFromFile(file);
+    }
+}
+
+double fileMegabytes(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return static_cast<double>(file.tellg()) / (1024.0 * 1024.0);
+}
+
+}
+
+TEST(parseAmountMatchesStrtod) {
+    const char* inputs[] = {
+        "0", "-0.0", "12.5", " 99.99 \r", "1234567.89", "0.1", "1e22", "1e23",
+        "123456789012345678901", "1.7976931348623157e308", "4.9e-324", "2.5E-3", "+7"
+    };
+    for (const char* input : inputs) {
+        double parsed = -1.0;
+        CHECK(parseAmount(input, input + std::strlen(input), parsed));
+        CHECK(parsed == std::strtod(input, nullptr));
+    }
+
+    const char* rejected[] = { "", " ", "abc", "1.2.3", "1e", "--1", "12a", "." };
+    for (const char* input : rejected) {
+        double parsed;
+        CHECK(!parseAmount(input, input + std::strlen(input), parsed));
+    }
+}
+
+TEST(blockParserMatchesStreamParser) {
+    const std::string filename = testFile("parsers_agree.dat");
+    saveAccountsFile(filename, generatedBook(500, 40));
+
+    std::vector<BankAccount> fast, reference;
+    parseAccountsFile(filename, fast);
+    parseWithStream(filename, reference);
+    std::remove(filename.c_str());
+
+    CHECK(fast.size() == 500);
+    CHECK(sameBook(fast, reference));
+}
+
+TEST(parserThroughputInMegabytesPerSecond) {
+    // Reported rather than checked, so a busy machine cannot fail the run
+    const std::string filename = testFile("parsers_speed.dat");
+    saveAccountsFile(filename, generatedBook(10000, 40));
+    const double megabytes = fileMegabytes(filename);
+
+    std::vector<BankAccount> fast, reference;
+    const double streamSeconds = secondsToParse(parseWithStream, filename, reference);
+    const double fastSeconds = secondsToParse(parseAccountsFile, filename, fast);
+    std::remove(filename.c_str());
+
+    std::cout << "       " << megabytes << " MB: block parser " << megabytes / fastSeconds
+              << " MB/s, stream parser " << megabytes / streamSeconds << " MB/s\n";
+    CHECK(sameBook(fast, reference));
+}
@@ -0,0 +1,108 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "DataExchange.h"
+#include "AccountStorage.h"
+
+namespace {
+
+std::vector<BankAccount> sampleAccounts() {
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    accounts.push_back(BankAccount("A00002", "Maria \"Mimi\" Ivanova, Jr."));
+    accounts[0].addDeposit(1234567.89);
+    accounts[0].addDeposit(0.1);
+    accounts[0].addWithdrawal(20.25);
+    accounts[1].addWithdrawal(75.0);
+    return accounts;
+}
+
+void writeAll(const std::string& filename, const std::string& content) {
+    std::ofstream file(filename, std::ios::binary);
+    file << content;
+}
+
+}
+
+TEST(jsonLinesImportRoundTrips) {
+    const std::string filename = testFile("round_trip.jsonl");
+    const std::vector<BankAccount> original = sampleAccounts();
+    exportAccounts(original, filename, ExchangeRecords::Accounts);
+
+    std::vector<BankAccount> accounts;
+    AccountIndex index;
+    ImportResult result = importRecords(filename, ExchangeRecords::Accounts, accounts, index);
+    std::remove(filename.c_str());
+
+    CHECK(result.imported == 2 && result.rejected == 0);
+    CHECK(accounts.size() == 2);
+    for (size_t i = 0; i < accounts.size(); ++i) {
+        CHECK(std::strcmp(accounts[i].getUniqueCode(), original[i].getUniqueCode()) == 0);
+        CHECK(std::strcmp(accounts[i].getOwnerName(), original[i].getOwnerName()) == 0);
+        CHECK(accounts[i].getDepositedCount() == original[i].getDepositedCount());
+        CHECK(accounts[i].getWithdrawnCount() == original[i].getWithdrawnCount());
+        CHECK(accounts[i].getTotalDeposited() == original[i].getTotalDeposited());
+        CHECK(accounts[i].getTotalWithdrawn() == original[i].getTotalWithdrawn());
+    }
+}
+
+TEST(importRejectsDuplicateCodesAndIndexesNewAccounts) {
+    const std::string filename = testFile("duplicates.csv");
+    writeAll(filename,
+             "code,owner\n"
+             "A00001,Ivan Petrov\n"         // Already in the book
+             "B00001,Nina Koleva\n"
+             "b00001,Nina Koleva\n"         // Earlier in the same file
+             "B00002,Petar Stoyanov\n");
+
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    AccountIndex index;
+    index.rebuild(accounts);
+    ImportResult result = importRecords(filename, ExchangeRecords::Accounts, accounts, index);
+    std::remove(filename.c_str());
+
+    CHECK(result.imported == 2);
+    CHECK(result.rejected == 2);
+    CHECK(accounts.size() == 3);
+    CHECK(index.size() == 3);
+    size_t position = 0;
+    CHECK(index.findCode("B00002", position) && position == 2);
+}
+
+TEST(jsonImportRejectsUnpairedSurrogates) {
+    const std::string filename = testFile("surrogates.jsonl");
+    writeAll(filename,
+             "{\"code\":\"A00001\",\"owner\":\"Smile \\ud83d\\ude00\"}\n"
+             "{\"code\":\"A00002\",\"owner\":\"High then letter \\ud83d\\u0041\"}\n"
+             "{\"code\":\"A00003\",\"owner\":\"Lone high \\ud83d\"}\n"
+             "{\"code\":\"A00004\",\"owner\":\"Lone low \\ude00\"}\n");
+
+    std::vector<BankAccount> accounts;
+    AccountIndex index;
+    ImportResult result = importRecords(filename, ExchangeRecords::Accounts, accounts, index);
+    std::remove(filename.c_str());
+
+    CHECK(result.imported == 1 && result.rejected == 3);
+    CHECK(std::strcmp(accounts[0].getOwnerName(), "Smile \xF0\x9F\x98\x80") == 0);
+}
+
+TEST(exportRefusesCorruptedDataFile) {
+    const std::string dataFile = testFile("export_source.dat");
+    const std::string filename = testFile("export_corrupted.csv");
+    saveAccountsFile(dataFile, sampleAccounts());
+    {
+        std::fstream file(dataFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(3);
+        file.put('9');
+    }
+
+    CHECK_THROWS(exportDataFile(dataFile, filename, ExchangeRecords::Transactions));
+    std::ifstream output(filename);
+    const bool created = output.is_open();
+    output.close();
+    std::remove(dataFile.c_str());
+    std::remove(filename.c_str());
+    CHECK(!created);
+}
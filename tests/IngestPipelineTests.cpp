@@ -0,0 +1,124 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include "IngestPipeline.h"
+#include "SpscQueue.h"
+
+namespace {
+
+void writeAll(const std::string& filename, const std::string& content) {
+    std::ofstream file(filename, std::ios::binary);
+    file << content;
+}
+
+size_t countLines(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(file, line)) {
+        ++lines;
+    }
+    return lines;
+}
+
+}
+
+TEST(queueHandsOverEveryValueInOrder) {
+    SpscQueue<int> queue(2);
+    const int count = 20000;
+    std::thread producer([&queue]() {
+        for (int i = 1; i <= count; ++i) {
+            queue.push(i);
+        }
+    });
+
+    bool ordered = true;
+    for (int expected = 1; expected <= count; ++expected) {
+        if (queue.pop() != expected) {
+            ordered = false;
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(queue.highWaterMark() <= queue.capacity());
+}
+
+TEST(closingQueueReleasesBlockedSides) {
+    SpscQueue<int> empty(2);
+    int popped = -1;
+    std::thread consumer([&]() { popped = empty.pop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Long enough to be asleep
+    empty.close();
+    consumer.join();
+    CHECK(popped == 0);
+    CHECK(!empty.push(5));
+
+    SpscQueue<int> full(2);
+    full.push(1);
+    full.push(2);
+    bool pushed = true;
+    std::thread producer([&]() { pushed = full.push(3); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    full.close();
+    producer.join();
+    CHECK(!pushed);
+}
+
+TEST(pipelineAppliesGoodRowsAndRejectsTheRest) {
+    const std::string feed = testFile("feed.csv");
+    const std::string journal = testFile("feed.journal");
+    writeAll(feed,
+             "code,type,amount\n"
+             "A00001,deposit,100.5\n"
+             "A00009,deposit,10\n"          // Unknown account
+             "A00002,deposit,abc\n"         // Bad amount
+             "A00002,withdrawal,-5\n"       // Negative
+             "A00002,deposit,40\n"
+             "A00001,withdrawal,0.5\n");
+
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    accounts.push_back(BankAccount("A00002", "Maria Ivanova"));
+    AccountIndex index;
+    index.rebuild(accounts);
+    TransferEngine transfers(accounts, nullptr, journal);
+
+    IngestReport report = ingestTransactions(feed, index, transfers);
+
+    CHECK(report.error.empty());
+    CHECK(report.rows == 6);
+    CHECK(report.applied == 3);
+    CHECK(report.rejected == 3);
+    CHECK(accounts[0].getBalance() == 100.0);
+    CHECK(accounts[1].getBalance() == 40.0);
+    CHECK(countLines(feed + ".rejected") == 3);
+
+    std::remove(feed.c_str());
+    std::remove((feed + ".rejected").c_str());
+    std::remove(journal.c_str());
+}
+
+TEST(unwritableRejectedFileIsReported) {
+    const std::string feed = testFile("blocked.csv");
+    const std::string journal = testFile("blocked.journal");
+    const std::string blocker = feed + ".rejected";
+    makeBlocker(blocker);
+    writeAll(feed, "code,type,amount\nA00009,deposit,10\n");
+
+    std::vector<BankAccount> accounts(1, BankAccount("A00001", "Ivan Petrov"));
+    AccountIndex index;
+    index.rebuild(accounts);
+    TransferEngine transfers(accounts, nullptr, journal);
+    IngestReport report = ingestTransactions(feed, index, transfers);
+
+    removeBlocker(blocker);
+    std::remove(feed.c_str());
+    std::remove(journal.c_str());
+
+    CHECK(report.rejected == 1);
+    CHECK(!report.error.empty());
+    CHECK(report.rejectedFile.empty());
+}
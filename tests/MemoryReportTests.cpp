@@ -0,0 +1,65 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include "MemoryReport.h"
+#include "HeapBytes.h"
+#include "AccountStorage.h"
+
+TEST(heapBytesSkipsStringsStoredInPlace) {
+    const std::string shortText("A00001");
+    const std::string longText(200, 'x');
+    CHECK(heapBytes(std::string()) == 0);
+    CHECK(heapBytes(longText) >= longText.size() + 1);
+    CHECK(heapBytes(shortText) == 0 || heapBytes(shortText) >= shortText.size() + 1);
+}
+
+TEST(compactionTrimsOnlyAccountsIdleSinceThePreviousCompaction) {
+    std::vector<BankAccount> accounts;
+    accounts.reserve(8);
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    for (int i = 0; i < 100; ++i) {
+        accounts[0].addDeposit(1.0 + i);
+    }
+    const double balance = accounts[0].getBalance();
+    CHECK(accounts[0].getDepositedCapacity() == 128);
+
+    // Recent transactions: the geometric headroom stays
+    CompactionResult first = compactAccounts(accounts);
+    CHECK(first.active == 1 && first.dormant == 0);
+    CHECK(accounts[0].getDepositedCapacity() == 128);
+    CHECK(accounts.capacity() == 1);
+
+    // No transactions since: trimmed to fit
+    CHECK(accounts[0].isDormant());
+    CompactionResult second = compactAccounts(accounts);
+    CHECK(second.active == 0 && second.dormant == 1);
+    CHECK(accounts[0].getDepositedCapacity() == 100);
+    CHECK(second.bytesAfter < second.bytesBefore);
+
+    CHECK(accounts[0].getDepositedCount() == 100);
+    CHECK(accounts[0].getDepositedAmount(99) == 100.0);
+    CHECK(accounts[0].getBalance() == balance);
+}
+
+TEST(loadedAccountsAppendWithoutReallocating) {
+    const std::string filename = testFile("headroom.dat");
+    std::vector<BankAccount> saved(1, BankAccount("A00001", "Ivan Petrov"));
+    for (int i = 0; i < 100; ++i) {
+        saved[0].addDeposit(1.0 + i);
+    }
+    saveAccountsFile(filename, saved);
+
+    std::vector<BankAccount> accounts;
+    CHECK(loadAccountsFile(filename, accounts));
+    std::remove(filename.c_str());
+    const int capacity = accounts[0].getDepositedCapacity();
+    CHECK(capacity > 100);
+
+    // A compaction right after the load does not take the headroom away
+    CompactionResult result = compactAccounts(accounts);
+    CHECK(result.dormant == 0);
+    CHECK(accounts[0].getDepositedCapacity() == capacity);
+
+    accounts[0].addDeposit(5.0);
+    CHECK(accounts[0].getDepositedCapacity() == capacity);
+    CHECK(accounts[0].getDepositedCount() == 101);
+}
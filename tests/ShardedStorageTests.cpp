@@ -0,0 +1,177 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include "ShardedStorage.h"
+#include "AccountStorage.h"
+
+namespace {
+
+const size_t SHARD_COUNT = 4;
+
+std::vector<BankAccount> sampleAccounts() {
+    std::vector<BankAccount> accounts;
+    for (int i = 0; i < 40; ++i) {
+        char code[8];
+        std::snprintf(code, sizeof(code), "S%05d", i);
+        accounts.push_back(BankAccount(code, "Ivan Petrov"));
+        accounts.back().addDeposit(100.0 + i);
+    }
+    return accounts;
+}
+
+bool exists(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return file.is_open();
+}
+
+void damage(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    in.close();
+    std::string bytes = content.str();
+    bytes[0] = bytes[0] == '9' ? '8' : '9';
+    std::ofstream out(filename, std::ios::binary);
+    out << bytes;
+}
+
+void cleanUp(const std::string& manifest) {
+    for (size_t shard = 0; shard < SHARD_COUNT; ++shard) {
+        const std::string name = shardFileName(manifest, shard, SHARD_COUNT);
+        std::remove(name.c_str());
+        std::remove((name + ".corrupt").c_str());
+    }
+    std::remove(manifest.c_str());
+    std::remove((manifest + ".corrupt").c_str());
+}
+
+}
+
+TEST(firstShardSaveRetiresTheSingleFile) {
+    const std::string manifest = testFile("retire.manifest");
+    const std::string single = testFile("retire.dat");
+    saveAccountsFile(single, sampleAccounts());
+
+    std::vector<BankAccount> book = sampleAccounts();
+    ShardReport saved = saveShards(manifest, book, SHARD_COUNT);
+    CHECK(saved.failedCount() == 0 && saved.writtenCount() == SHARD_COUNT);
+    CHECK(!exists(single));
+
+    std::vector<BankAccount> accounts;
+    ShardReport loaded;
+    CHECK(loadShards(manifest, accounts, loaded));
+    CHECK(loaded.failedCount() == 0);
+    CHECK(accounts.size() == 40);
+
+    // Nothing changed since the load, so no shard is written
+    CHECK(saveShards(manifest, accounts, SHARD_COUNT).writtenCount() == 0);
+    cleanUp(manifest);
+}
+
+TEST(damagedManifestIsRebuiltFromShards) {
+    const std::string manifest = testFile("rebuild.manifest");
+    std::vector<BankAccount> book = sampleAccounts();
+    saveShards(manifest, book, SHARD_COUNT);
+    damage(manifest);
+
+    std::vector<BankAccount> accounts;
+    ShardReport report;
+    CHECK_THROWS(loadShards(manifest, accounts, report));
+    CHECK(recoverShards(manifest, accounts, report));
+    CHECK(accounts.size() == 40);
+    CHECK(exists(manifest + ".corrupt"));
+
+    std::vector<BankAccount> reloaded;
+    CHECK(loadShards(manifest, reloaded, report));
+    CHECK(report.failedCount() == 0 && reloaded.size() == 40);
+    cleanUp(manifest);
+}
+
+TEST(incompleteShardLayoutIsNotRecovered) {
+    const std::string manifest = testFile("incomplete.manifest");
+    std::vector<BankAccount> book = sampleAccounts();
+    saveShards(manifest, book, SHARD_COUNT);
+    std::remove(shardFileName(manifest, 2, SHARD_COUNT).c_str());
+    damage(manifest);
+
+    std::vector<BankAccount> accounts(1);
+    ShardReport report;
+    CHECK(!recoverShards(manifest, accounts, report));
+    CHECK(accounts.size() == 1);
+    CHECK(exists(manifest));
+    book = sampleAccounts();
+    CHECK_THROWS(saveShards(manifest, book, SHARD_COUNT));
+    cleanUp(manifest);
+}
+
+TEST(shardSetAsideIsReportedAsMissing) {
+    const std::string manifest = testFile("missing.manifest");
+    std::vector<BankAccount> book = sampleAccounts();
+    saveShards(manifest, book, SHARD_COUNT);
+    const std::string shard = shardFileName(manifest, 1, SHARD_COUNT);
+    damage(shard);
+
+    std::vector<BankAccount> accounts;
+    ShardReport report;
+    CHECK(loadShards(manifest, accounts, report));
+    CHECK(report.failedCount() == 1);
+    CHECK(accounts.size() < 40);
+
+    CHECK(missingShards(manifest).empty());
+    std::rename(shard.c_str(), (shard + ".corrupt").c_str());
+    std::vector<std::string> missing = missingShards(manifest);
+    CHECK(missing.size() == 1 && missing[0] == shard);
+    cleanUp(manifest);
+}
+
+TEST(onlyShardsWithChangedAccountsAreWritten) {
+    const std::string manifest = testFile("dirty.manifest");
+    std::vector<BankAccount> book = sampleAccounts();
+    saveShards(manifest, book, SHARD_COUNT);
+
+    std::vector<BankAccount> accounts;
+    ShardReport report;
+    CHECK(loadShards(manifest, accounts, report));
+    accounts[0].addDeposit(5.0);
+    const size_t changed = shardOf(accounts[0].getUniqueCode(), SHARD_COUNT);
+    ShardReport saved = saveShards(manifest, accounts, SHARD_COUNT);
+    CHECK(saved.writtenCount() == 1 && saved.shards[changed].written);
+
+    // A new account marks its shard too
+    accounts.push_back(BankAccount("T00001", "Maria Ivanova"));
+    const size_t added = shardOf("T00001", SHARD_COUNT);
+    saved = saveShards(manifest, accounts, SHARD_COUNT);
+    CHECK(saved.writtenCount() == 1 && saved.shards[added].written);
+    CHECK(saveShards(manifest, accounts, SHARD_COUNT).writtenCount() == 0);
+
+    std::vector<BankAccount> reloaded;
+    CHECK(loadShards(manifest, reloaded, report));
+    CHECK(report.failedCount() == 0 && reloaded.size() == 41);
+    for (const auto& shard : report.shards) {
+        CHECK(shard.warning.empty());
+    }
+    cleanUp(manifest);
+}
+
+TEST(failedLayoutChangeLeavesNoOrphans) {
+    const std::string manifest = testFile("relayout.manifest");
+    std::vector<BankAccount> book = sampleAccounts();
+    saveShards(manifest, book, SHARD_COUNT);
+
+    // One shard of the new two-shard layout cannot be written
+    const std::string blocked = shardFileName(manifest, 1, 2) + ".tmp";
+    makeBlocker(blocked);
+    ShardReport saved = saveShards(manifest, book, 2);
+    removeBlocker(blocked);
+
+    CHECK(saved.failedCount() == 1);
+    CHECK(!exists(shardFileName(manifest, 0, 2)));
+    CHECK(readShardCount(manifest) == SHARD_COUNT);
+    std::vector<BankAccount> accounts;
+    ShardReport report;
+    CHECK(loadShards(manifest, accounts, report));
+    CHECK(report.failedCount() == 0 && accounts.size() == 40);
+    cleanUp(manifest);
+}
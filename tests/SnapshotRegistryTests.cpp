@@ -0,0 +1,56 @@
+#include "TestFramework.h"
+#include "SnapshotRegistry.h"
+
+namespace {
+
+std::vector<BankAccount> makeBook(size_t count) {
+    std::vector<BankAccount> accounts;
+    for (size_t i = 0; i < count; ++i) {
+        std::string code = std::to_string(100000 + i);
+        code[0] = 'B';
+        accounts.push_back(BankAccount(code.c_str(), "A rather long owner name that is not inlined"));
+        accounts.back().addDeposit(10.0);
+    }
+    return accounts;
+}
+
+}
+
+TEST(publishedVersionsStayUnchanged) {
+    std::vector<BankAccount> accounts = makeBook(600);
+    SnapshotRegistry snapshots;
+    snapshots.publishAll(accounts);
+    std::shared_ptr<const BookSnapshot> before = snapshots.acquire();
+
+    accounts[300].addDeposit(5.0);
+    accounts.push_back(BankAccount("C00001", "New Owner"));
+    snapshots.publish(accounts, std::vector<size_t>(1, 300));
+    std::shared_ptr<const BookSnapshot> after = snapshots.acquire();
+
+    CHECK(after->getVersion() == before->getVersion() + 1);
+    CHECK(before->size() == 600 && after->size() == 601);
+    CHECK((*before)[300].totalDeposited == 10.0);
+    CHECK((*after)[300].totalDeposited == 15.0);
+    CHECK((*after)[300].depositStats.count == 2);
+    CHECK((*after)[600].getUniqueCode() == "C00001");
+}
+
+TEST(publishSharesCodeAndNameStrings) {
+    std::vector<BankAccount> accounts = makeBook(300);
+    SnapshotRegistry snapshots;
+    snapshots.publishAll(accounts);
+    std::shared_ptr<const BookSnapshot> before = snapshots.acquire();
+
+    accounts[10].addWithdrawal(1.0);
+    snapshots.publish(accounts, std::vector<size_t>(1, 10));
+    std::shared_ptr<const BookSnapshot> after = snapshots.acquire();
+
+    // Both the changed entry and its copied neighbours point at the same strings
+    CHECK(&(*before)[10].getOwnerName() == &(*after)[10].getOwnerName());
+    CHECK(&(*before)[11].getUniqueCode() == &(*after)[11].getUniqueCode());
+
+    accounts[10].setOwnerName("Renamed Owner");
+    snapshots.publish(accounts, std::vector<size_t>(1, 10));
+    CHECK(snapshots.acquire()->operator[](10).getOwnerName() == "Renamed Owner");
+    CHECK((*after)[10].getOwnerName() != "Renamed Owner");
+}
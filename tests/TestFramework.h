@@ -0,0 +1,59 @@
+#ifndef TEST_FRAMEWORK_H
+#define TEST_FRAMEWORK_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Minimal self-registering test cases. A failed CHECK reports its location
+// and ends the current test; run_tests exits non-zero if any test failed.
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+    const char* name;
+    TestFunction function;
+};
+
+std::vector<TestCase>& testRegistry();
+void reportFailure(const char* file, int line, const std::string& message);
+
+// Path for a scratch file under build/, removed by the test that creates it
+std::string testFile(const std::string& name);
+
+// Creates a directory holding one file, which neither std::remove nor an
+// ofstream can replace; used to make a write fail. removeBlocker undoes it.
+void makeBlocker(const std::string& path);
+void removeBlocker(const std::string& path);
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, TestFunction function) {
+        TestCase test = { name, function };
+        testRegistry().push_back(test);
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            reportFailure(__FILE__, __LINE__, #condition); \
+            return; \
+        } \
+    } while (0)
+
+#define CHECK_THROWS(expression) \
+    do { \
+        bool thrown = false; \
+        try { expression; } catch (const std::exception&) { thrown = true; } \
+        if (!thrown) { \
+            reportFailure(__FILE__, __LINE__, "expected an exception: " #expression); \
+            return; \
+        } \
+    } while (0)
+
+#endif
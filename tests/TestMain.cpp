@@ -0,0 +1,63 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <fstream>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+int failures = 0;
+
+}
+
+std::vector<TestCase>& testRegistry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+void reportFailure(const char* file, int line, const std::string& message) {
+    std::cout << "  FAILED " << file << ":" << line << ": " << message << "\n";
+    ++failures;
+}
+
+std::string testFile(const std::string& name) {
+    return "build/test_" + name;
+}
+
+void makeBlocker(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+    std::ofstream((path + "/keep").c_str()) << "x";
+}
+
+void removeBlocker(const std::string& path) {
+    std::remove((path + "/keep").c_str());
+    std::remove(path.c_str());
+}
+
+int main() {
+    int failedTests = 0;
+    for (const auto& test : testRegistry()) {
+        const int before = failures;
+        try {
+            test.function();
+        } catch (const std::exception& e) {
+            reportFailure(test.name, 0, std::string("unexpected exception: ") + e.what());
+        }
+        const bool passed = failures == before;
+        std::cout << (passed ? "[OK]   " : "[FAIL] ") << test.name << "\n";
+        if (!passed) {
+            ++failedTests;
+        }
+    }
+
+    std::cout << "\n" << testRegistry().size() - static_cast<size_t>(failedTests) << " of "
+              << testRegistry().size() << " tests passed\n";
+    return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include "TestFramework.h"
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+#include "AccountStorage.h"
+#include "TransactionStats.h"
+
+TEST(welfordStatsMatchTwoPassResults) {
+    // A large common offset is where the textbook sum-of-squares formula falls apart
+    const double amounts[] = { 1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16 };
+    TransactionStats stats = TransactionStats::of(amounts, 4);
+
+    CHECK(stats.count == 4);
+    CHECK(stats.mean == 1e9 + 10);
+    CHECK(std::fabs(stats.variance() - 22.5) < 1e-6);
+    CHECK(stats.min == 1e9 + 4 && stats.max == 1e9 + 16 && stats.last == 1e9 + 16);
+    CHECK(stats.largeCount == 4);
+
+    // The last amount is judged against the three before it (mean 1e9 + 8, stddev sqrt(14))
+    CHECK(std::fabs(stats.lastDeviation() - 8.0 / std::sqrt(14.0)) < 1e-6);
+}
+
+TEST(savedAmountsAndStatsReloadExactly) {
+    const std::string filename = testFile("stats_round_trip.dat");
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    accounts[0].addDeposit(1234567.89);
+    accounts[0].addDeposit(0.1);
+    accounts[0].addDeposit(98765432.123456789);
+    accounts[0].addWithdrawal(33.333333333333336);
+    saveAccountsFile(filename, accounts);
+
+    std::vector<BankAccount> loaded;
+    CHECK(loadAccountsFile(filename, loaded));
+    std::remove(filename.c_str());
+
+    CHECK(loaded.size() == 1);
+    for (int i = 0; i < accounts[0].getDepositedCount(); ++i) {
+        CHECK(loaded[0].getDepositedAmount(i) == accounts[0].getDepositedAmount(i));
+    }
+    CHECK(loaded[0].getWithdrawnAmount(0) == 33.333333333333336);
+    const TransactionStats& saved = accounts[0].getDepositStats();
+    const TransactionStats& reloaded = loaded[0].getDepositStats();
+    CHECK(reloaded.mean == saved.mean && reloaded.m2 == saved.m2 && reloaded.last == saved.last);
+}
+
+TEST(statsThatDoNotMatchStoredAmountsAreRecomputed) {
+    // Written by a version that saved amounts with 6 significant digits
+    TransactionStats exact;
+    exact.add(1234567.89);
+    std::ostringstream content;
+    content << "1\nA00001\nIvan Petrov\n1\n1.23457e+06\n0\n";
+    writeStatsLine(content, exact, TransactionStats());
+
+    const std::string filename = testFile("stale_stats.dat");
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << content.str();
+    }
+    std::vector<BankAccount> loaded;
+    CHECK(loadAccountsFile(filename, loaded));
+    std::remove(filename.c_str());
+
+    CHECK(loaded.size() == 1);
+    CHECK(loaded[0].getDepositStats().last == 1234570.0);
+    CHECK(loaded[0].getDepositStats().mean == 1234570.0);
+}
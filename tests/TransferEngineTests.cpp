@@ -0,0 +1,117 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <string>
+#include "TransferEngine.h"
+
+namespace {
+
+std::vector<BankAccount> makeAccounts() {
+    std::vector<BankAccount> accounts;
+    accounts.push_back(BankAccount("A00001", "Ivan Petrov"));
+    accounts.push_back(BankAccount("A00002", "Maria Ivanova"));
+    accounts.push_back(BankAccount("A00003", "Georgi Dimitrov"));
+    accounts[0].addDeposit(100.0);
+    accounts[1].addDeposit(50.0);
+    return accounts;
+}
+
+Transfer makeTransfer(size_t from, size_t to, double amount) {
+    Transfer transfer = { from, to, amount };
+    return transfer;
+}
+
+}
+
+TEST(transferBatchIsPostedWhole) {
+    const std::string journal = testFile("transfers.journal");
+    std::vector<BankAccount> accounts = makeAccounts();
+    SnapshotRegistry snapshots;
+    snapshots.publishAll(accounts);
+    {
+        TransferEngine engine(accounts, &snapshots, journal);
+        std::vector<Transfer> batch;
+        batch.push_back(makeTransfer(0, 1, 30.0));
+        batch.push_back(makeTransfer(1, 2, 70.0));
+        CHECK(engine.applyBatch(batch) == 1);
+    }
+    std::remove(journal.c_str());
+
+    CHECK(accounts[0].getBalance() == 70.0);
+    CHECK(accounts[1].getBalance() == 10.0);
+    CHECK(accounts[2].getBalance() == 70.0);
+    std::shared_ptr<const BookSnapshot> snapshot = snapshots.acquire();
+    CHECK((*snapshot)[2].getBalance() == 70.0);
+}
+
+TEST(conflictingTransferBatchChangesNothing) {
+    const std::string journal = testFile("conflict.journal");
+    std::vector<BankAccount> accounts = makeAccounts();
+    {
+        TransferEngine engine(accounts, nullptr, journal);
+        std::vector<Transfer> batch;
+        batch.push_back(makeTransfer(0, 2, 80.0));
+        batch.push_back(makeTransfer(0, 1, 30.0)); // Together they overdraw A00001
+        CHECK_THROWS(engine.applyBatch(batch));
+    }
+    std::remove(journal.c_str());
+
+    CHECK(accounts[0].getWithdrawnCount() == 0);
+    CHECK(accounts[1].getDepositedCount() == 1);
+    CHECK(accounts[2].getDepositedCount() == 0);
+}
+
+TEST(journalRecordsExactAmounts) {
+    const std::string journal = testFile("exact.journal");
+    std::vector<BankAccount> accounts = makeAccounts();
+    accounts[0].addDeposit(2000000.0);
+    {
+        TransferEngine engine(accounts, nullptr, journal);
+        std::vector<Transfer> batch(1, makeTransfer(0, 1, 1234567.89));
+        engine.applyBatch(batch);
+    }
+
+    std::ifstream file(journal);
+    std::string header, from, to, footer;
+    double amount = 0;
+    std::getline(file, header);
+    file >> from >> to >> amount >> footer;
+    file.close();
+    std::remove(journal.c_str());
+
+    CHECK(header == "BATCH 1 1");
+    CHECK(from == "A00001" && to == "A00002");
+    CHECK(amount == 1234567.89);
+    CHECK(footer == "END");
+}
+
+TEST(transferAmountsMustBeFiniteAndPositive) {
+    const std::string journal = testFile("invalid.journal");
+    std::vector<BankAccount> accounts = makeAccounts();
+    TransferEngine engine(accounts, nullptr, journal);
+    const double invalid[] = { 0.0, -1.0, std::numeric_limits<double>::quiet_NaN(),
+                               std::numeric_limits<double>::infinity() };
+    for (double amount : invalid) {
+        std::vector<Transfer> batch(1, makeTransfer(0, 1, amount));
+        CHECK_THROWS(engine.applyBatch(batch));
+    }
+    CHECK(accounts[0].getBalance() == 100.0);
+    std::remove(journal.c_str());
+}
+
+TEST(repeatedReservationsGrowGeometrically) {
+    BankAccount account("A00001", "Ivan Petrov");
+    int reallocations = 0;
+    int capacity = account.getDepositedCapacity();
+    for (int i = 0; i < 10000; ++i) {
+        account.reserveTransactions(1, 0);
+        account.addDeposit(1.0);
+        if (account.getDepositedCapacity() != capacity) {
+            capacity = account.getDepositedCapacity();
+            ++reallocations;
+        }
+    }
+    CHECK(reallocations < 30);
+}